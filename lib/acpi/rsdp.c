@@ -1,5 +1,7 @@
 #include <string.h>
 #include <acpi/rsdp.h>
+#include <arch/page.h>
+#include <kernel/init.h>
 
 
 /*
@@ -8,12 +10,12 @@
  *
  * @return  The address of the RSDP structure, or NULL if not found
  */
-struct RSDPDescriptor* find_rsdp(void){
+struct RSDPDescriptor* __init find_rsdp(void){
     uint32_t base_addr = 0xB0000;
 
     for(; base_addr<=0xFFFFF; base_addr+=16){
-        if(0 == strncmp("RSD PTR ", (char*)base_addr, sizeof("RSD PTR ")-1))
-            return (struct RSDPDescriptor *) base_addr; 
+        if(0 == strncmp("RSD PTR ", (char*) __va(base_addr), sizeof("RSD PTR ")-1))
+            return (struct RSDPDescriptor *) __va(base_addr); 
     }
 
     return NULL;
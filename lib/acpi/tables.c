@@ -0,0 +1,100 @@
+#include <string.h>
+#include <acpi/acpi.h>
+#include <acpi/madt.h>
+#include <arch/page.h>
+#include <arch/paging.h>
+#include <kernel/init.h>
+
+
+/*
+ * Root System Description Table: the header is followed by 32-bit physical
+ * pointers to every other table
+ */
+struct acpi_rsdt {
+    struct acpi_sdt_header header;
+    uint32_t entries[];
+} __attribute__ ((packed));
+
+
+static int __init acpi_checksum_ok(const void *table, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *) table;
+    uint8_t sum = 0;
+
+    while(len--)
+        sum += *p++;
+
+    return 0 == sum;
+}
+
+
+/*
+ * Tables normally sit in RAM covered by the direct map; firmware is free to
+ * put them anywhere, though
+ */
+static void * __init acpi_map(phys_addr_t addr, uint32_t len)
+{
+    if( ((uint64_t) addr + len) <= DIRECT_MAP_SIZE )
+        return __va(addr);
+
+    return ioremap(addr, len);
+}
+
+
+static struct acpi_sdt_header * __init acpi_map_table(phys_addr_t addr)
+{
+    struct acpi_sdt_header *hdr = acpi_map(addr, sizeof(*hdr));
+
+    if(NULL == hdr)
+        return NULL;
+
+    /* Now that the length is known, map all of it */
+    hdr = acpi_map(addr, hdr->length);
+    if( (NULL == hdr) || !acpi_checksum_ok(hdr, hdr->length) )
+        return NULL;
+
+    return hdr;
+}
+
+
+struct acpi_sdt_header * __init acpi_find_table(const char *signature)
+{
+    struct RSDPDescriptor *rsdp = find_rsdp();
+    struct acpi_rsdt *rsdt;
+    uint32_t count;
+
+    if( (NULL == rsdp) || !acpi_checksum_ok(rsdp, sizeof(*rsdp)) )
+        return NULL;
+
+    rsdt = (struct acpi_rsdt *) acpi_map_table(rsdp->RsdtAddress);
+    if( (NULL == rsdt) || (0 != strncmp(rsdt->header.signature, "RSDT", 4)) )
+        return NULL;
+
+    count = (rsdt->header.length - sizeof(rsdt->header)) / sizeof(rsdt->entries[0]);
+    for(uint32_t i = 0; i < count; i++){
+        struct acpi_sdt_header *hdr = acpi_map(rsdt->entries[i], sizeof(*hdr));
+
+        if( (NULL != hdr) && (0 == strncmp(hdr->signature, signature, 4)) )
+            return acpi_map_table(rsdt->entries[i]);
+    }
+
+    return NULL;
+}
+
+
+void __init acpi_madt_foreach(const struct acpi_madt *madt, acpi_madt_fn_t fn, void *ctx)
+{
+    const uint8_t *p = (const uint8_t *) (madt + 1);
+    const uint8_t *end = (const uint8_t *) madt + madt->header.length;
+
+    while(p + sizeof(struct acpi_madt_entry) <= end){
+        const struct acpi_madt_entry *entry = (const struct acpi_madt_entry *) p;
+
+        /* A zero length entry would loop forever; treat it as the end */
+        if( (entry->length < sizeof(*entry)) || (p + entry->length > end) )
+            break;
+
+        fn(entry, ctx);
+        p += entry->length;
+    }
+}
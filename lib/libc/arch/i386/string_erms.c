@@ -0,0 +1,43 @@
+#include <string.h>
+#include <libc/string_impl.h>
+
+/*
+ * On CPUs advertising ERMS (CPUID.7.0:EBX[9]), rep movsb/stosb are the
+ * preferred bulk primitives: the microcode handles alignment internally, so
+ * no head/body/tail split is needed. Short operations still go through the
+ * word loops, where the fixed startup cost of the string instructions would
+ * dominate.
+ */
+
+
+void *memcpy_erms(void *restrict dstptr, const void *restrict srcptr, size_t size)
+{
+	void *dst = dstptr;
+	const void *src = srcptr;
+
+	if (size < STRING_REP_THRESHOLD)
+		return memcpy_words(dstptr, srcptr, size);
+
+	asm volatile("rep movsb"
+	             : "+D"(dst), "+S"(src), "+c"(size)
+	             :
+	             : "memory");
+
+	return dstptr;
+}
+
+
+void *memset_erms(void *bufptr, int value, size_t size)
+{
+	void *dst = bufptr;
+
+	if (size < STRING_REP_THRESHOLD)
+		return memset_words(bufptr, value, size);
+
+	asm volatile("rep stosb"
+	             : "+D"(dst), "+c"(size)
+	             : "a"(value)
+	             : "memory");
+
+	return bufptr;
+}
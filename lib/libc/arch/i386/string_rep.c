@@ -0,0 +1,73 @@
+#include <string.h>
+#include <libc/string_impl.h>
+
+/*
+ * Bulk copy/fill routines built on the x86 string instructions. Fast-string
+ * microcode moves whole cache lines per iteration once the count is large,
+ * so these are used for anything above STRING_REP_THRESHOLD.
+ *
+ * The destination is first brought to dword alignment with a short rep movsb/
+ * stosb, then the body is moved with rep movsd/stosd, and the remaining 0-3
+ * bytes finish with another rep movsb/stosb. The direction flag is clear per
+ * the i386 calling convention, so all copies run forward.
+ */
+
+
+void *memcpy_rep(void *restrict dstptr, const void *restrict srcptr, size_t size)
+{
+	void *dst = dstptr;
+	const void *src = srcptr;
+	size_t head = (-(uintptr_t)dstptr) & WORD_MASK;
+	size_t words;
+
+	if (head > size)
+		head = size;
+	size -= head;
+	words = size / WORD_SIZE;
+	size &= WORD_MASK;
+
+	asm volatile("rep movsb"
+	             : "+D"(dst), "+S"(src), "+c"(head)
+	             :
+	             : "memory");
+	asm volatile("rep movsl"
+	             : "+D"(dst), "+S"(src), "+c"(words)
+	             :
+	             : "memory");
+	asm volatile("rep movsb"
+	             : "+D"(dst), "+S"(src), "+c"(size)
+	             :
+	             : "memory");
+
+	return dstptr;
+}
+
+
+void *memset_rep(void *bufptr, int value, size_t size)
+{
+	void *dst = bufptr;
+	word_t pattern = WORD_REPEAT(value);
+	size_t head = (-(uintptr_t)bufptr) & WORD_MASK;
+	size_t words;
+
+	if (head > size)
+		head = size;
+	size -= head;
+	words = size / WORD_SIZE;
+	size &= WORD_MASK;
+
+	asm volatile("rep stosb"
+	             : "+D"(dst), "+c"(head)
+	             : "a"(pattern)
+	             : "memory");
+	asm volatile("rep stosl"
+	             : "+D"(dst), "+c"(words)
+	             : "a"(pattern)
+	             : "memory");
+	asm volatile("rep stosb"
+	             : "+D"(dst), "+c"(size)
+	             : "a"(pattern)
+	             : "memory");
+
+	return bufptr;
+}
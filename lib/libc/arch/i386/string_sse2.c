@@ -0,0 +1,166 @@
+#include <string.h>
+#include <libc/string_impl.h>
+
+/*
+ * SSE2 string routines. The heavy lifting is done by the loops in
+ * string_sse2_asm.S; these wrappers handle the unaligned edges with the
+ * word routines and feed the vector loops in bounded chunks.
+ *
+ * The kernel does not save the vector registers on interrupt entry, so any
+ * handler that itself ends up here would corrupt an interrupted loop. Each
+ * chunk therefore runs with interrupts disabled, and SSE2_CHUNK bounds how
+ * long they stay off.
+ */
+
+#define SSE2_THRESHOLD  128
+#define SSE2_CHUNK      4096
+
+
+void sse2_copy_blocks(void *dst, const void *src, size_t nblocks);
+void sse2_fill_blocks(void *dst, uint32_t pattern, size_t nblocks);
+size_t sse2_mismatch(const void *a, const void *b, size_t nblocks);
+size_t sse2_find_zero(const char *p, size_t nblocks);
+
+
+#ifdef __KERN__
+static inline unsigned long sse2_begin(void)
+{
+	unsigned long flags;
+	asm volatile("pushfl; popl %0; cli" : "=r"(flags) : : "memory");
+	return flags;
+}
+
+
+static inline void sse2_end(unsigned long flags)
+{
+	asm volatile("pushl %0; popfl" : : "r"(flags) : "memory", "cc");
+}
+#else
+static inline unsigned long sse2_begin(void) { return 0; }
+static inline void sse2_end(unsigned long flags) { (void) flags; }
+#endif
+
+
+void *memcpy_sse2(void *restrict dstptr, const void *restrict srcptr, size_t size)
+{
+	unsigned char *dst = (unsigned char *) dstptr;
+	const unsigned char *src = (const unsigned char *) srcptr;
+	unsigned long flags;
+	size_t head, chunk;
+
+	if (size < SSE2_THRESHOLD)
+		return memcpy_scalar(dstptr, srcptr, size);
+
+	/* Align the destination so the stores can use movdqa */
+	head = (-(uintptr_t)dst) & 15;
+	memcpy_words(dst, src, head);
+	dst += head;
+	src += head;
+	size -= head;
+
+	while (size >= 64) {
+		chunk = size & ~(size_t)63;
+		if (chunk > SSE2_CHUNK)
+			chunk = SSE2_CHUNK;
+
+		flags = sse2_begin();
+		sse2_copy_blocks(dst, src, chunk / 64);
+		sse2_end(flags);
+
+		dst += chunk;
+		src += chunk;
+		size -= chunk;
+	}
+
+	memcpy_words(dst, src, size);
+	return dstptr;
+}
+
+
+void *memset_sse2(void *bufptr, int value, size_t size)
+{
+	unsigned char *dst = (unsigned char *) bufptr;
+	unsigned long flags;
+	size_t head, chunk;
+
+	if (size < SSE2_THRESHOLD)
+		return memset_scalar(bufptr, value, size);
+
+	head = (-(uintptr_t)dst) & 15;
+	memset_words(dst, value, head);
+	dst += head;
+	size -= head;
+
+	while (size >= 64) {
+		chunk = size & ~(size_t)63;
+		if (chunk > SSE2_CHUNK)
+			chunk = SSE2_CHUNK;
+
+		flags = sse2_begin();
+		sse2_fill_blocks(dst, WORD_REPEAT(value), chunk / 64);
+		sse2_end(flags);
+
+		dst += chunk;
+		size -= chunk;
+	}
+
+	memset_words(dst, value, size);
+	return bufptr;
+}
+
+
+int memcmp_sse2(const void *aptr, const void *bptr, size_t size)
+{
+	const unsigned char *a = (const unsigned char *) aptr;
+	const unsigned char *b = (const unsigned char *) bptr;
+	unsigned long flags;
+	size_t chunk, offset;
+
+	if (size < SSE2_THRESHOLD)
+		return memcmp_scalar(aptr, bptr, size);
+
+	while (size >= 16) {
+		chunk = size & ~(size_t)15;
+		if (chunk > SSE2_CHUNK)
+			chunk = SSE2_CHUNK;
+
+		flags = sse2_begin();
+		offset = sse2_mismatch(a, b, chunk / 16);
+		sse2_end(flags);
+
+		if (offset < chunk)
+			return (a[offset] < b[offset]) ? -1 : 1;
+
+		a += chunk;
+		b += chunk;
+		size -= chunk;
+	}
+
+	return memcmp_scalar(a, b, size);
+}
+
+
+size_t strlen_sse2(const char *str)
+{
+	const char *p = str;
+	unsigned long flags;
+	size_t offset;
+
+	/* Walk bytewise up to the first 16-byte boundary; short strings end here */
+	while ((uintptr_t)p & 15) {
+		if ('\0' == *p)
+			return p - str;
+		p++;
+	}
+
+	for (;;) {
+		flags = sse2_begin();
+		offset = sse2_find_zero(p, SSE2_CHUNK / 16);
+		sse2_end(flags);
+
+		if (offset < SSE2_CHUNK)
+			return (p + offset) - str;
+
+		p += SSE2_CHUNK;
+	}
+}
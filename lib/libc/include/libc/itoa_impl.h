@@ -0,0 +1,30 @@
+#ifndef _LIBC_ITOA_IMPL_H
+#define _LIBC_ITOA_IMPL_H
+
+#include <stdint.h>
+
+
+/* Large enough for 64 binary digits, a sign and the nul-terminator */
+#define ITOA_BUF_SIZE   66
+
+/* Flags for the *_rev conversion routines */
+#define ITOA_UPPER      0x01    /* Use 'A'-'Z' for digits above 9 */
+
+
+/*
+ * Core conversion engine shared by the itoa family and the printf family.
+ * Digits are written backwards, ending just before 'end'; no sign and no
+ * nul-terminator are added. The routines never touch shared state, so they
+ * are safe to call from interrupt context.
+ *
+ * @param end   : One past the last byte the digits may occupy
+ * @param num   : The number to convert
+ * @param base  : The base to convert to, 2 through 36
+ * @param flags : ITOA_* flags
+ * @return      : A pointer to the first (most significant) digit
+ */
+char *utoa_rev(char *end, uint32_t num, unsigned int base, int flags);
+char *ulltoa_rev(char *end, uint64_t num, unsigned int base, int flags);
+
+
+#endif /* _LIBC_ITOA_IMPL_H */
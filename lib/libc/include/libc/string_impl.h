@@ -0,0 +1,126 @@
+#ifndef _LIBC_STRING_IMPL_H
+#define _LIBC_STRING_IMPL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*
+ * The native machine word used by the word-at-a-time string routines. It is
+ * marked may_alias since the routines walk arbitrary byte buffers with it
+ */
+typedef uint32_t __attribute__((__may_alias__)) word_t;
+
+#define WORD_SIZE           (sizeof(word_t))
+#define WORD_MASK           (WORD_SIZE - 1)
+#define WORD_ALIGNED(p)     (0 == ((uintptr_t)(p) & WORD_MASK))
+
+/* Replicate a byte into every byte lane of a word */
+#define WORD_REPEAT(c)      ((word_t)(unsigned char)(c) * 0x01010101u)
+
+/*
+ * Non-zero iff some byte of w is zero. Bits above the lowest flagged byte may
+ * be set spuriously by the borrow, but the lowest one is always exact
+ */
+#define WORD_ONES           0x01010101u
+#define WORD_HIGHS          0x80808080u
+#define WORD_HAS_ZERO(w)    (((w) - WORD_ONES) & ~(w) & WORD_HIGHS)
+
+/* Index of the first (lowest-addressed) flagged byte of a WORD_HAS_ZERO() mask */
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define WORD_ZERO_INDEX(m)  ((size_t)__builtin_ctz(m) >> 3)
+#else
+#define WORD_ZERO_INDEX(m)  ((size_t)__builtin_clz(m) >> 3)
+#endif
+
+/*
+ * Routines that read past the end of a string may only do so within the page
+ * holding the terminator. Aligned word loads always satisfy this
+ */
+#define STRING_PAGE_SIZE            4096
+#define WORD_IN_PAGE(p)     (((uintptr_t)(p) & (STRING_PAGE_SIZE - 1)) <= STRING_PAGE_SIZE - WORD_SIZE)
+
+/* x86 tolerates misaligned word loads, so only the destination needs aligning */
+#if defined(__i386__) || defined(__x86_64__)
+#define WORD_UNALIGNED_OK   1
+#else
+#define WORD_UNALIGNED_OK   0
+#endif
+
+/*
+ * Operations at or above this size are handed to the rep-string variants; below
+ * it, the setup cost of the microcoded string instructions dominates
+ */
+#define STRING_REP_THRESHOLD    64
+
+
+/*
+ * Word-at-a-time implementations. These align the destination with a byte
+ * head, move whole words and finish with a byte tail
+ */
+void *memcpy_words(void *__restrict dst, const void *__restrict src, size_t size);
+void *memset_words(void *buf, int value, size_t size);
+
+
+/*
+ * Portable implementations; the default bindings before string_impl_init()
+ */
+void *memcpy_scalar(void *__restrict dst, const void *__restrict src, size_t size);
+void *memset_scalar(void *buf, int value, size_t size);
+int memcmp_scalar(const void *a, const void *b, size_t size);
+size_t strlen_scalar(const char *str);
+
+
+#if defined(__i386__)
+/*
+ * Equivalents built on rep movsd/rep stosd, found in arch/i386
+ */
+void *memcpy_rep(void *__restrict dst, const void *__restrict src, size_t size);
+void *memset_rep(void *buf, int value, size_t size);
+
+/*
+ * Enhanced REP MOVSB/STOSB: byte-granular string instructions that the CPU
+ * runs at full cache-line width regardless of alignment
+ */
+void *memcpy_erms(void *__restrict dst, const void *__restrict src, size_t size);
+void *memset_erms(void *buf, int value, size_t size);
+
+/*
+ * 128-bit SSE2 implementations
+ */
+void *memcpy_sse2(void *__restrict dst, const void *__restrict src, size_t size);
+void *memset_sse2(void *buf, int value, size_t size);
+int memcmp_sse2(const void *a, const void *b, size_t size);
+size_t strlen_sse2(const char *str);
+#endif
+
+
+/*
+ * The routines the public string functions dispatch through. Bound once at
+ * boot by string_impl_init(), after which it is effectively read-only
+ */
+struct string_ops {
+    void *(*memcpy)(void *__restrict dst, const void *__restrict src, size_t size);
+    void *(*memset)(void *buf, int value, size_t size);
+    int (*memcmp)(const void *a, const void *b, size_t size);
+    size_t (*strlen)(const char *str);
+};
+
+extern struct string_ops g_string_ops;
+
+
+/* CPU capabilities the caller can report to string_impl_init() */
+#define STRING_FEAT_ERMS    (1 << 0)
+#define STRING_FEAT_SSE2    (1 << 1)
+
+/*
+ * Select the fastest implementation of each routine for the given CPU
+ * features. Callers are responsible for having enabled the features (e.g.
+ * CR4.OSFXSR for SSE2) before reporting them
+ *
+ * @param features  : A mask of STRING_FEAT_* flags
+ */
+void string_impl_init(unsigned int features);
+
+
+#endif /* _LIBC_STRING_IMPL_H */
@@ -4,6 +4,17 @@
 #include <stddef.h>
 #include <stdarg.h>
 
+
+/*
+ * Output sink for vcbprintf(). Called with consecutive runs of formatted
+ * output, in order
+ * @param ctx   : The context pointer passed to vcbprintf()
+ * @param data  : The run of output (not nul-terminated)
+ * @param len   : Length of the run
+ * @return      : Non-zero to discard all further output
+ */
+typedef int (*printf_sink_t)(void *ctx, const char *data, size_t len);
+
  
 //int printf(const char* __restrict, ...);
 char putchar(char);
@@ -11,5 +22,12 @@ char putchar(char);
 int snprintf(char *buffer, size_t size, const char *fmt, ...);
 int vsnprintf(char *buf, size_t len, const char *format, va_list va);
 
+/*
+ * Format directly into a sink, without an intermediate buffer. Literal text
+ * and each converted field are handed to the sink as they are produced
+ * @return      : The total length of the formatted output
+ */
+int vcbprintf(printf_sink_t sink, void *ctx, const char *format, va_list va);
+
 
 #endif /* _STDIO_H */
@@ -10,33 +10,22 @@ void abort(void);
 
 
 /*
- * Convert an integer of a given base to its ASCII equivalent. Of course, the current implementation 
- * is not reentrant. 
- * @param num   : The number to convert
- * @param base  : The base of the passed intger
- * @return      : A pointer to a local static buffer containing the converted result
- */
-char *itoa(int num, int base); 
-
-
-/*
- * Convert an integer of a given base to its ASCII equivalent. Of course, the current implementation 
- * is not reentrant. 
- * @param num   : The number to convert
- * @param base  : The base of the passed intger
- * @return      : A pointer to a local static buffer containing the converted result
- */
-char *ltoa(long long num, int base); 
-
-
-/*
- * The reetrant equivalent of itoa
+ * Convert an integer of a given base to its ASCII equivalent. The result is 
+ * written to a caller-supplied buffer, so these are reentrant and safe to use
+ * from interrupt context. In base 10, negative values of the signed variants
+ * are prefixed with '-'; in other bases their two's complement bit pattern
+ * is converted. ITOA_BUF_SIZE (libc/itoa_impl.h) bytes always suffice
+ *
  * @param num   : The number to convert
  * @param str   : Buffer to copy the results
  * @param len   : The length of the buffer passed
- * @param base  : The base of the passed intger
- * @return      : A pointer to the buffer containing the converted result
+ * @param base  : The base to convert to, 2 through 36
+ * @return      : A pointer to the buffer containing the converted result, or
+ *                NULL if the base is invalid or the buffer is too small
  */
 char *itoa_r(int num, char *str, int len, int base);
+char *utoa_r(unsigned int num, char *str, int len, int base);
+char *ltoa_r(long long num, char *str, int len, int base);
+char *ultoa_r(unsigned long long num, char *str, int len, int base);
  
 #endif
@@ -3,29 +3,10 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdint.h>
+#include <stddef.h>
+#include <libc/itoa_impl.h>
 
 
-/* 
- * TODO
- * - Implement proper formatting using the already collected flag and width information
- * - Implement proper boundary checking (implement macro for writing to buffer that jumps to out label when full
- * - Implement proper printing of long, long long, and pointer types
- */
-
-
-/*
- * State definitions for snprintf as it parses a format string
- */
-enum state {
-    STATE_CHAR,
-    STATE_PERCENT_SIGN,
-    STATE_FLAGS,
-    STATE_WIDTH,
-    STATE_PRECISION,
-    STATE_LENGTH,
-    STATE_SPECIFIER
-};
-
 /* Length definitions */
 enum length_modes {
     LENGTH_H,
@@ -33,6 +14,8 @@ enum length_modes {
     LENGTH_L,
     LENGTH_LL,
     LENGTH_Z,
+    LENGTH_J,
+    LENGTH_T,
     LENGTH_UNKNOWN,
     LENGTH_NONE
 };
@@ -42,232 +25,382 @@ enum flag_modes {
     FLAG_HASH =         0x02,
     FLAG_ZERO =         0x04,
     FLAG_SPACE =        0x08,
-    FLAG_PLUS =         0x10
+    FLAG_PLUS =         0x10,
+    FLAG_UPPER =        0x20
 };
 
 struct out_format {
     int flags;
     int width;
     int length;
-    int precision;
+    int precision;              /* -1 when not given */
+};
+
+/*
+ * Output state for a single vcbprintf() call. 'count' keeps growing after the
+ * sink asks to stop, so callers still learn the full formatted length
+ */
+struct cb_state {
+    printf_sink_t sink;
+    void *ctx;
+    size_t count;
+    int stopped;
 };
 
 
+static void cb_emit(struct cb_state *st, const char *data, size_t len)
+{
+    if( (0 != len) && !st->stopped ){
+        if(0 != st->sink(st->ctx, data, len))
+            st->stopped = 1;
+    }
+
+    st->count += len;
+}
+
+
+static void cb_pad(struct cb_state *st, char c, int count)
+{
+    static const char spaces[16] = "                ";
+    static const char zeros[16]  = "0000000000000000";
+    const char *run = ('0' == c) ? zeros : spaces;
+
+    while(count > 0){
+        int n = (count > (int) sizeof(spaces)) ? (int) sizeof(spaces) : count;
+        cb_emit(st, run, n);
+        count -= n;
+    }
+}
+
+
+/*
+ * Emit a field of 'len' bytes, space-padded to the requested width
+ */
+static void cb_field(struct cb_state *st, const struct out_format *out, const char *data, size_t len)
+{
+    int pad = out->width - (int) len;
+
+    if(!(out->flags & FLAG_LEFT_JUSTIFY))
+        cb_pad(st, ' ', pad);
+
+    cb_emit(st, data, len);
+
+    if(out->flags & FLAG_LEFT_JUSTIFY)
+        cb_pad(st, ' ', pad);
+}
+
+
+/*
+ * Emit an integer field: [spaces][sign/prefix][zeros][digits][spaces]
+ */
+static void cb_integer(struct cb_state *st, const struct out_format *out, uint64_t mag, int negative, unsigned int base)
+{
+    char buf[ITOA_BUF_SIZE];
+    char *end = buf + sizeof(buf);
+    char *digits;
+    char prefix[2];
+    int nprefix = 0, ndigits, nzeros = 0, pad;
+
+    /* An explicit zero precision with a zero value prints no digits at all */
+    if( (0 == out->precision) && (0 == mag) ){
+        digits = end;
+    }else{
+        digits = ulltoa_rev(end, mag, base, (out->flags & FLAG_UPPER) ? ITOA_UPPER : 0);
+    }
+    ndigits = end - digits;
+
+    if(negative)
+        prefix[nprefix++] = '-';
+    else if(out->flags & FLAG_PLUS)
+        prefix[nprefix++] = '+';
+    else if(out->flags & FLAG_SPACE)
+        prefix[nprefix++] = ' ';
+
+    if(out->flags & FLAG_HASH){
+        if( (16 == base) && (0 != mag) ){
+            prefix[nprefix++] = '0';
+            prefix[nprefix++] = (out->flags & FLAG_UPPER) ? 'X' : 'x';
+        }else if( (8 == base) && ((0 == ndigits) || ('0' != *digits)) ){
+            nzeros = 1;
+        }
+    }
+
+    if(out->precision > ndigits)
+        nzeros = out->precision - ndigits;
+
+    pad = out->width - (nprefix + nzeros + ndigits);
+
+    /* The '0' flag pads with zeros after the prefix; ignored with '-' or a precision */
+    if( (out->flags & FLAG_ZERO) && !(out->flags & FLAG_LEFT_JUSTIFY) && (out->precision < 0) && (pad > 0) ){
+        nzeros += pad;
+        pad = 0;
+    }
+
+    if(!(out->flags & FLAG_LEFT_JUSTIFY))
+        cb_pad(st, ' ', pad);
+
+    cb_emit(st, prefix, nprefix);
+    cb_pad(st, '0', nzeros);
+    cb_emit(st, digits, ndigits);
+
+    if(out->flags & FLAG_LEFT_JUSTIFY)
+        cb_pad(st, ' ', pad);
+}
+
+
+/*
+ * Parse a run of decimal digits, advancing the format pointer past them
+ */
+static int parse_decimal(const char **format)
+{
+    int value = 0;
+
+    while( (**format >= '0') && (**format <= '9') ){
+        value = value*10 + (**format - '0');
+        (*format)++;
+    }
+
+    return value;
+}
+
+
+/* Note: short/char are promoted to int when passed to variadic functions */
+static int64_t fetch_signed(int length, va_list *va)
+{
+    switch(length){
+        case LENGTH_HH: return (signed char) va_arg(*va, int);
+        case LENGTH_H:  return (short) va_arg(*va, int);
+        case LENGTH_L:  return va_arg(*va, long);
+        case LENGTH_LL:
+        case LENGTH_J:  return va_arg(*va, long long);
+        case LENGTH_Z:  return (ptrdiff_t) va_arg(*va, size_t);
+        case LENGTH_T:  return va_arg(*va, ptrdiff_t);
+        default:        return va_arg(*va, int);
+    }
+}
+
+
+static uint64_t fetch_unsigned(int length, va_list *va)
+{
+    switch(length){
+        case LENGTH_HH: return (unsigned char) va_arg(*va, unsigned int);
+        case LENGTH_H:  return (unsigned short) va_arg(*va, unsigned int);
+        case LENGTH_L:  return va_arg(*va, unsigned long);
+        case LENGTH_LL:
+        case LENGTH_J:  return va_arg(*va, unsigned long long);
+        case LENGTH_Z:  return va_arg(*va, size_t);
+        case LENGTH_T:  return (size_t) va_arg(*va, ptrdiff_t);
+        default:        return va_arg(*va, unsigned int);
+    }
+}
+
+
 /*
  * Note that some of the special cases (e.g. tab) must be implemented 
  * explicitly if printing to the VGA console, which is not a _real_
  * console program that interprets control keys 
  */
-int vsnprintf(char *buf, size_t len, const char *format, va_list va)
+int vcbprintf(printf_sink_t sink, void *ctx, const char *format, va_list va)
 {
-    struct out_format out = {0};
-    int state = STATE_CHAR;
-    int f_index = 0;
-    int b_index = 0;
-    int index_increment = 0;
-
-    while('\0' != format[f_index]){
-
-        switch(state){
-            case STATE_CHAR:
-                /* Check character special cases first */
-                switch(format[f_index]){
-                    case '%':
-                        state = STATE_PERCENT_SIGN;
-                        break;
-                    default:
-                        buf[b_index++] = format[f_index];
-                        break;
-                }
-                
-                index_increment = 1;
-                break;
+    struct cb_state st = { .sink = sink, .ctx = ctx, .count = 0, .stopped = 0 };
+    va_list ap;
 
-            case STATE_PERCENT_SIGN:
-                if('%' == format[f_index]){
-                    buf[b_index++] = format[f_index];
-                    state = STATE_CHAR;
-                    index_increment = 1;    /* For safety, but STATE_CHAR has already set this */
-                    break;
-                }
+    /* Work on a copy so the helpers can advance it through a pointer */
+    va_copy(ap, va);
 
-                state = STATE_FLAGS;
-                index_increment = 0;
-                break;
+    while('\0' != *format){
+        struct out_format out = { .flags = 0, .width = 0, .length = LENGTH_NONE, .precision = -1 };
+        const char *run = format;
 
-            case STATE_FLAGS:
-                switch(format[f_index]){
-                    case '-':
-                        out.flags |= FLAG_LEFT_JUSTIFY;
-                        index_increment = 1; 
-                        break;
-                    case '+':
-                        buf[b_index++] = '+';
-                        out.flags |= FLAG_PLUS;
-                        index_increment = 1; 
-                        break;
-                    case '#':
-                        out.flags |= FLAG_HASH;
-                        index_increment = 1; 
-                        break;
-                    case '0': 
-                        out.flags |= FLAG_ZERO;
-                        index_increment = 1; 
-                        break;
-                    case ' ':
-                        out.flags |= FLAG_SPACE;
-                        index_increment = 1; 
-                        break;
-                    default:
-                        index_increment = 0; 
-                        break;
-                }
+        /* Pass literal text through in a single run */
+        while( ('\0' != *format) && ('%' != *format) )
+            format++;
+        cb_emit(&st, run, format - run);
 
-                state = STATE_WIDTH;
-                break;
+        if('\0' == *format)
+            break;
+        format++;   /* Skip the '%' */
 
-            case STATE_WIDTH:
-                if('*' == format[f_index]){
-                    out.width = va_arg(va, int);
-                    index_increment = 1;
-                }else{ 
-                    //TODO: implement width
-                    index_increment = 0;
-                }
+        /* Flags */
+        for(;;){
+            switch(*format){
+                case '-': out.flags |= FLAG_LEFT_JUSTIFY; format++; continue;
+                case '+': out.flags |= FLAG_PLUS;         format++; continue;
+                case '#': out.flags |= FLAG_HASH;         format++; continue;
+                case '0': out.flags |= FLAG_ZERO;         format++; continue;
+                case ' ': out.flags |= FLAG_SPACE;        format++; continue;
+                default: break;
+            }
+            break;
+        }
 
-                state = STATE_PRECISION;
-                break;
+        /* Width; a negative '*' argument means left-justify */
+        if('*' == *format){
+            out.width = va_arg(ap, int);
+            if(out.width < 0){
+                out.flags |= FLAG_LEFT_JUSTIFY;
+                out.width = -out.width;
+            }
+            format++;
+        }else{
+            out.width = parse_decimal(&format);
+        }
 
-            case STATE_PRECISION:
-                if('*' == format[f_index]){
-                    out.precision = va_arg(va, int);
-                    index_increment = 1;
-                }else{ 
-                    //TODO: implement precision
-                    index_increment = 0;
+        /* Precision; a negative '*' argument means none was given */
+        if('.' == *format){
+            format++;
+            if('*' == *format){
+                out.precision = va_arg(ap, int);
+                if(out.precision < 0)
+                    out.precision = -1;
+                format++;
+            }else{
+                out.precision = parse_decimal(&format);
+            }
+        }
+
+        /* Length */
+        switch(*format){
+            case 'h':
+                if('h' == format[1]){
+                    out.length = LENGTH_HH;
+                    format++;
+                }else{
+                    out.length = LENGTH_H;
                 }
-                state = STATE_LENGTH;
+                format++;
                 break;
-
-            case STATE_LENGTH:
-                switch(format[f_index]){
-                    case 'h':
-                        if('h' == format[f_index + 1]){
-                            out.length = LENGTH_HH;
-                            index_increment = 2;
-                        }else{
-                            out.length = LENGTH_H;
-                            index_increment = 1;
-                        }
-                        break;
-                    case 'l':
-                        if('l' == format[f_index + 1]){
-                            out.length = LENGTH_LL;
-                            index_increment = 2;
-                        }else{
-                            out.length = LENGTH_L;
-                            index_increment = 1; 
-                        }
-                        break;
-                    case 'z':
-                        out.length = LENGTH_Z;
-                        index_increment = 1; 
-                        break;
-                    /* Some unimplemented length modifiers */
-                    case 'j':
-                    case 't':
-                    case 'L':
-                        out.length = LENGTH_UNKNOWN;
-                        index_increment = 1; 
-                        break; 
-                    default:
-                        out.length = LENGTH_NONE;
-                        index_increment = 0; 
-                        break;
+            case 'l':
+                if('l' == format[1]){
+                    out.length = LENGTH_LL;
+                    format++;
+                }else{
+                    out.length = LENGTH_L;
                 }
-
-                state = STATE_SPECIFIER;
+                format++;
                 break;
+            case 'z': out.length = LENGTH_Z; format++; break;
+            case 'j': out.length = LENGTH_J; format++; break;
+            case 't': out.length = LENGTH_T; format++; break;
+            /* Some unimplemented length modifiers */
+            case 'L': out.length = LENGTH_UNKNOWN; format++; break;
+            default: break;
+        }
 
-             /* Note: short/char are promoted to int when passed to variadic functions */
-            case STATE_SPECIFIER:
+        /* Specifier */
+        switch(*format){
+            case 'd':
+            case 'i':
             {
-                char *str;
-                int base = 10;
-
-                switch(format[f_index]){
-                    case 'x':
-                    case 'X':
-                    case 'd':
-                    case 'i':
-                    case 'u':
-                    {
-                        /* Certain cases that land here will change the base of the interpretation */
-                        if( 'x' == format[f_index] || 'X' == format[f_index] ){
-                            base = 16;
-                        }
-            
-                        switch(out.length){
-                            case LENGTH_NONE:
-                            case LENGTH_H:
-                            case LENGTH_HH:
-                                str = itoa(va_arg(va, int), base);
-                                break;
-                            case LENGTH_L:
-                                str = itoa(va_arg(va, long), base);
-                                break;
-                            case LENGTH_LL:
-                                str = itoa(va_arg(va, long long), base);
-                                break;
-                            case LENGTH_Z:
-                                str = itoa(va_arg(va, size_t), base);
-                                break;
-                            default:
-                                buf[b_index++] = va_arg(va, int);       /* Treat the unknown case like characters */
-                                break;
-                        }
-                        memcpy(&buf[b_index], str, strlen(str));
-                        b_index += strlen(str);
-                    }
-                        break;
-                    case 'c':
-                        buf[b_index++] = va_arg(va, int);
-                        break;
-                    case 's':
-                    {
-                        str = va_arg(va, char *);
-                        strncpy(&buf[b_index], str, len-b_index);
-                        b_index += strlen(str);
-                    }
-                        break;
-                    case 'p':
-                    {
-                        
-                        str = itoa((int)va_arg(va, void*), 16);
-                        memcpy(&buf[b_index], str, strlen(str));
-                        b_index += strlen(str);
-                    }
-                        break;
-                    default:
-                        buf[b_index++] = '?';
-                        break;
-                }        
-                index_increment = 1; 
-                state = STATE_CHAR;
+                int64_t value = fetch_signed(out.length, &ap);
+                uint64_t mag = (value < 0) ? 0u - (uint64_t) value : (uint64_t) value;
+                cb_integer(&st, &out, mag, value < 0, 10);
             }
                 break;
+            case 'u':
+                cb_integer(&st, &out, fetch_unsigned(out.length, &ap), 0, 10);
+                break;
+            case 'o':
+                cb_integer(&st, &out, fetch_unsigned(out.length, &ap), 0, 8);
+                break;
+            case 'X':
+                out.flags |= FLAG_UPPER;
+                __attribute__((fallthrough));
+            case 'x':
+                cb_integer(&st, &out, fetch_unsigned(out.length, &ap), 0, 16);
+                break;
+            case 'p':
+                out.flags |= FLAG_HASH;
+                cb_integer(&st, &out, (uintptr_t) va_arg(ap, void *), 0, 16);
+                break;
+            case 'c':
+            {
+                char c = (char) va_arg(ap, int);
+                cb_field(&st, &out, &c, 1);
+            }
+                break;
+            case 's':
+            {
+                const char *str = va_arg(ap, const char *);
+                size_t len = 0;
+
+                if(NULL == str)
+                    str = "(null)";
+
+                /* Never read past 'precision' bytes; the string need not be terminated */
+                while( ((out.precision < 0) || (len < (size_t) out.precision)) && ('\0' != str[len]) )
+                    len++;
 
+                cb_field(&st, &out, str, len);
+            }
+                break;
+            case '%':
+                cb_emit(&st, "%", 1);
+                break;
+            case '\0':
+                /* Format ended mid-conversion; don't run past the terminator */
+                format--;
+                break;
             default:
+                cb_emit(&st, "?", 1);
                 break;
         }
 
-        f_index += index_increment;
+        format++;
     }
 
-//TODO: create a macro for adding elements to the buffer that jumps here if it does not fit
-//add_newline_exit:
-    buf[b_index++] = '\0';
-    return b_index;
+    va_end(ap);
+    return (int) st.count;
+}
+
+
+/*
+ * Bounded buffer sink backing vsnprintf()
+ */
+struct buf_sink {
+    char *buf;
+    size_t len;
+    size_t pos;
+};
+
+
+static int buf_sink_write(void *ctx, const char *data, size_t len)
+{
+    struct buf_sink *bs = (struct buf_sink *) ctx;
+    size_t room = bs->len - 1 - bs->pos;    /* Always leave room for the nul */
+
+    if(len > room)
+        len = room;
+
+    memcpy(&bs->buf[bs->pos], data, len);
+    bs->pos += len;
+
+    /* Full; no point in feeding us more */
+    return (bs->pos == bs->len - 1);
+}
+
+
+/*
+ * Returns the length the fully formatted string would have (excluding the
+ * nul), which may exceed the buffer. The output is always nul-terminated
+ * when len is non-zero
+ */
+int vsnprintf(char *buf, size_t len, const char *format, va_list va)
+{
+    struct buf_sink bs = { .buf = buf, .len = len, .pos = 0 };
+    char dummy;
+    int ret;
+
+    /* A zero-length buffer still reports the would-be length */
+    if(0 == len){
+        bs.buf = &dummy;
+        bs.len = 1;
+    }
+
+    ret = vcbprintf(buf_sink_write, &bs, format, va);
+    bs.buf[bs.pos] = '\0';
+
+    return ret;
 }
 
 
@@ -1,125 +1,234 @@
+#include <stddef.h>
+#include <stdint.h>
 #include <string.h>
-#define NUM_DIGITS 32 
+#include <stdlib.h>
+#include <libc/itoa_impl.h>
+
+/*
+ * Integer to ASCII conversion.
+ *
+ * Base 10 emits two digits per step from a pair table, dividing by 100 via a
+ * multiply with the fixed-point reciprocal instead of a div instruction. 64-bit
+ * values are first split into 9-digit chunks; on i386 each split is a single
+ * hardware divl rather than a call into libgcc's __udivdi3. Power-of-two
+ * bases need only shifts and masks. Any other base falls back to division.
+ */
+
+static const char g_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char g_digits_lower[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+static const char g_digits_upper[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+
+/* n / 100 for any 32-bit n: multiply by ceil(2^37 / 100) and keep the top bits */
+static inline uint32_t div100(uint32_t n)
+{
+    return (uint32_t) (((uint64_t) n * 0x51eb851fu) >> 37);
+}
 
 
 /*
- * Convert an integer of a given base to its ASCII equivalent. This implementation is not reentrant 
- * is not reentrant. 
- * @param num   : The number to convert
- * @param base  : The base of the passed intger
- * @return      : A pointer to a local static buffer containing the converted result
+ * Divide a 64-bit value in place by a 32-bit divisor, returning the remainder.
+ * Splitting off the high word first keeps the divl quotient within 32 bits
  */
-//TODO: Pass in external buffer for use, or NULL to use internal
-char *itoa(int num, int base) 
+static inline uint32_t div64_u32(uint64_t *n, uint32_t divisor)
 {
-    static char buf[NUM_DIGITS] = {0};
-    unsigned int _num; 
-    int digit, negative = 0;
-    char *dst = buf + sizeof(buf) - 1;  /* Start at the end */
-    
-    /* Special case for base 10 if the passed integer is negative */
-    if( (num < 0) && (10 == base) ){
-        negative = 1;
-        num *= -1;
-    }
-        
-    _num  = (unsigned int) num;
+#if defined(__i386__)
+    uint32_t hi = (uint32_t) (*n >> 32);
+    uint32_t lo = (uint32_t) *n;
+    uint32_t q_hi = hi / divisor;
+    uint32_t rem;
+
+    hi -= q_hi * divisor;
+    asm("divl %4" : "=a"(lo), "=d"(rem) : "a"(lo), "d"(hi), "rm"(divisor));
+    *n = ((uint64_t) q_hi << 32) | lo;
+
+    return rem;
+#else
+    uint32_t rem = (uint32_t) (*n % divisor);
+    *n /= divisor;
+    return rem;
+#endif
+}
 
-    /* While we haven't converted all digits and still have room for nul-term */
-    do{
-        digit = _num % base;
 
-        if(digit < 0xA){
-            *--dst = '0' + digit;
-        }else{
-            *--dst = 'a' + digit - 0xA;
-        }
-        _num /= base;
-    }while(_num != 0);
+static char *fmt_dec32(char *end, uint32_t num)
+{
+    while(num >= 100){
+        uint32_t q = div100(num);
+        uint32_t r = (num - q*100) * 2;
+
+        end -= 2;
+        end[0] = g_digit_pairs[r];
+        end[1] = g_digit_pairs[r + 1];
+        num = q;
+    }
 
-    /* We worked backwards, so the negative case should be the last thing we check for */
-    if(negative){
-        *--dst = '-';
+    if(num >= 10){
+        end -= 2;
+        end[0] = g_digit_pairs[num*2];
+        end[1] = g_digit_pairs[num*2 + 1];
+    }else{
+        *--end = '0' + num;
     }
 
-    return dst;
+    return end;
 }
 
 
-/*
- * Convert a long long integer of a given base to its ASCII equivalent. This implementation is not reentrant 
- * @param num   : The number to convert
- * @param base  : The base of the passed intger
- * @return      : A pointer to a local static buffer containing the converted result
- */
-char *ltoa(long long num, int base) 
+static char *fmt_pow2(char *end, uint64_t num, unsigned int base, const char *digits)
 {
-    static char buf[NUM_DIGITS] = {0};
-    unsigned int digit;
-    unsigned long long number = (unsigned long long) num;
-    int neg_flag = 0;
-    char *dst = buf + sizeof(buf)-1;  /* Start at the end */
-
-    /* Special case for base 10 if the passed integer is negative */
-    if( (num < 0) && (10 == base) ){
-        neg_flag = 1;
-        num *= -1;
+    unsigned int shift = __builtin_ctz(base);
+    unsigned int mask = base - 1;
+
+    /* Work on 32-bit halves where possible; 64-bit shifts are multi-instruction on i386 */
+    while(num >> 32){
+        *--end = digits[(uint32_t) num & mask];
+        num >>= shift;
     }
-    
-    /* While we haven't converted all digits and still have room for nul-term */
+
+    uint32_t n32 = (uint32_t) num;
     do{
-        digit = number % base;
-        if(digit < 0xA)
-            *--dst = '0' + digit;
-        else
-            *--dst = 'A' + digit - 0xA;
-        number /= base;
-    }while(number != 0);
-
-    /* We worked backwards, so the negative case should be the last thing we check for */
-    if(1 == neg_flag)
-        *--dst = '-';
-
-    return dst;
+        *--end = digits[n32 & mask];
+        n32 >>= shift;
+    }while(0 != n32);
+
+    return end;
 }
 
 
-/*
- * The reetrant equivalent of itoa
- * @param num   : The number to convert
- * @param str   : Buffer to copy the results
- * @param len   : The length of the buffer passed
- * @param base  : The base of the passed intger
- * @return      : A pointer to the buffer containing the converted result
- */
-char *itoa_r(int num, char* str, int len, int base)
+char *utoa_rev(char *end, uint32_t num, unsigned int base, int flags)
 {
-    int digit;
-    int i  = 0;
+    const char *digits = (flags & ITOA_UPPER) ? g_digits_upper : g_digits_lower;
 
-    /* Sanity check */
-    if( (len == 0) || (NULL == str) ) return NULL;
+    if(10 == base)
+        return fmt_dec32(end, num);
 
-    /* Special case for base 10 if the passed integer is negative */
-    if( (num < 0) && (base == 10) )
-        str[i++] = '-';
+    if(0 == (base & (base - 1)))
+        return fmt_pow2(end, num, base, digits);
 
-    /* While we haven't converted all digits and still have room for nul-term */
     do{
-        digit = num % base;
-        if (digit < 0xA)
-            str[i++] = '0' + digit;
-        else
-            str[i++] = 'A' + digit - 0xA;
-        
+        *--end = digits[num % base];
         num /= base;
-    }while( (num > 0) && (i < (len - 1)) );
+    }while(0 != num);
+
+    return end;
+}
+
+
+char *ulltoa_rev(char *end, uint64_t num, unsigned int base, int flags)
+{
+    const char *digits = (flags & ITOA_UPPER) ? g_digits_upper : g_digits_lower;
+
+    if(0 == (num >> 32))
+        return utoa_rev(end, (uint32_t) num, base, flags);
+
+    if(0 == (base & (base - 1)))
+        return fmt_pow2(end, num, base, digits);
+
+    if(10 == base){
+        /* Peel off 9-digit chunks, zero-padding all but the most significant */
+        while(num >> 32){
+            char *chunk_end = end;
+            end = fmt_dec32(end, div64_u32(&num, 1000000000u));
+            while(end > chunk_end - 9)
+                *--end = '0';
+        }
+
+        return fmt_dec32(end, (uint32_t) num);
+    }
+
+    do{
+        *--end = digits[div64_u32(&num, base)];
+    }while(0 != num);
+
+    return end;
+}
+
 
-    /* Not enough room in buffer */
-    if( (i == (len - 1)) && (num > 0) )
+/*
+ * Copy a converted number (and its sign) into the caller's buffer
+ */
+static char *itoa_copy_out(const char *start, const char *end, int negative, char *str, int len)
+{
+    size_t ndigits = end - start;
+
+    if( (NULL == str) || (len <= 0) || ((size_t) len < ndigits + negative + 1) )
         return NULL;
 
-    str[i] = '\0';
-    strrev(str);
+    if(negative)
+        str[0] = '-';
+
+    memcpy(&str[negative], start, ndigits);
+    str[negative + ndigits] = '\0';
+
     return str;
 }
+
+
+static int itoa_base_valid(int base)
+{
+    return (base >= 2) && (base <= 36);
+}
+
+
+char *itoa_r(int num, char *str, int len, int base)
+{
+    char buf[ITOA_BUF_SIZE];
+    char *end = buf + sizeof(buf);
+    int negative = (num < 0) && (10 == base);
+    uint32_t mag = negative ? 0u - (uint32_t) num : (uint32_t) num;
+
+    if(!itoa_base_valid(base))
+        return NULL;
+
+    return itoa_copy_out(utoa_rev(end, mag, base, 0), end, negative, str, len);
+}
+
+
+char *utoa_r(unsigned int num, char *str, int len, int base)
+{
+    char buf[ITOA_BUF_SIZE];
+    char *end = buf + sizeof(buf);
+
+    if(!itoa_base_valid(base))
+        return NULL;
+
+    return itoa_copy_out(utoa_rev(end, num, base, 0), end, 0, str, len);
+}
+
+
+char *ltoa_r(long long num, char *str, int len, int base)
+{
+    char buf[ITOA_BUF_SIZE];
+    char *end = buf + sizeof(buf);
+    int negative = (num < 0) && (10 == base);
+    uint64_t mag = negative ? 0u - (uint64_t) num : (uint64_t) num;
+
+    if(!itoa_base_valid(base))
+        return NULL;
+
+    return itoa_copy_out(ulltoa_rev(end, mag, base, 0), end, negative, str, len);
+}
+
+
+char *ultoa_r(unsigned long long num, char *str, int len, int base)
+{
+    char buf[ITOA_BUF_SIZE];
+    char *end = buf + sizeof(buf);
+
+    if(!itoa_base_valid(base))
+        return NULL;
+
+    return itoa_copy_out(ulltoa_rev(end, num, base, 0), end, 0, str, len);
+}
@@ -1,8 +1,20 @@
 #include <string.h>
+#include <libc/string_impl.h>
  
-int memcmp(const void* aptr, const void* bptr, size_t size) {
+int memcmp_scalar(const void* aptr, const void* bptr, size_t size) {
 	const unsigned char* a = (const unsigned char*) aptr;
 	const unsigned char* b = (const unsigned char*) bptr;
+
+	/* Skip over equal words; the byte loop below then locates the difference */
+	if (WORD_UNALIGNED_OK || (WORD_ALIGNED(a) && WORD_ALIGNED(b))) {
+		for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+			if (*(const word_t*) a != *(const word_t*) b)
+				break;
+			a += WORD_SIZE;
+			b += WORD_SIZE;
+		}
+	}
+
 	for (size_t i = 0; i < size; i++) {
 		if (a[i] < b[i])
 			return -1;
@@ -11,3 +23,8 @@ int memcmp(const void* aptr, const void* bptr, size_t size) {
 	}
 	return 0;
 }
+
+
+int memcmp(const void* aptr, const void* bptr, size_t size) {
+	return g_string_ops.memcmp(aptr, bptr, size);
+}
@@ -1,9 +1,56 @@
 #include <string.h>
- 
-void* memcpy(void* restrict dstptr, const void* restrict srcptr, size_t size) {
-	unsigned char* dst = (unsigned char*) dstptr;
-	const unsigned char* src = (const unsigned char*) srcptr;
-	for (size_t i = 0; i < size; i++)
-		dst[i] = src[i];
+#include <libc/string_impl.h>
+
+
+void *memcpy_words(void *restrict dstptr, const void *restrict srcptr, size_t size)
+{
+	unsigned char *dst = (unsigned char *) dstptr;
+	const unsigned char *src = (const unsigned char *) srcptr;
+
+	/* Head: copy bytes until the destination is word aligned */
+	while (size && !WORD_ALIGNED(dst)) {
+		*dst++ = *src++;
+		size--;
+	}
+
+	if (WORD_UNALIGNED_OK || WORD_ALIGNED(src)) {
+		word_t *wdst = (word_t *) dst;
+		const word_t *wsrc = (const word_t *) src;
+
+		for (; size >= 4*WORD_SIZE; size -= 4*WORD_SIZE) {
+			wdst[0] = wsrc[0];
+			wdst[1] = wsrc[1];
+			wdst[2] = wsrc[2];
+			wdst[3] = wsrc[3];
+			wdst += 4;
+			wsrc += 4;
+		}
+
+		for (; size >= WORD_SIZE; size -= WORD_SIZE)
+			*wdst++ = *wsrc++;
+
+		dst = (unsigned char *) wdst;
+		src = (const unsigned char *) wsrc;
+	}
+
+	/* Tail: whatever is left over (or everything, if the source was misaligned) */
+	while (size--)
+		*dst++ = *src++;
+
 	return dstptr;
 }
+
+
+void *memcpy_scalar(void *restrict dstptr, const void *restrict srcptr, size_t size)
+{
+#if defined(__i386__)
+	if (size >= STRING_REP_THRESHOLD)
+		return memcpy_rep(dstptr, srcptr, size);
+#endif
+	return memcpy_words(dstptr, srcptr, size);
+}
+
+
+void* memcpy(void* restrict dstptr, const void* restrict srcptr, size_t size) {
+	return g_string_ops.memcpy(dstptr, srcptr, size);
+}
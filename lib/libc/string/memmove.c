@@ -1,14 +1,77 @@
 #include <string.h>
- 
+#include <libc/string_impl.h>
+
+
+/*
+ * Copy towards higher addresses. Safe for overlapping buffers when dst < src,
+ * since every word is loaded before the store that could clobber it
+ */
+static void memmove_forward(unsigned char *dst, const unsigned char *src, size_t size)
+{
+	while (size && !WORD_ALIGNED(dst)) {
+		*dst++ = *src++;
+		size--;
+	}
+
+	if (WORD_UNALIGNED_OK || WORD_ALIGNED(src)) {
+		for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+			*(word_t *) dst = *(const word_t *) src;
+			dst += WORD_SIZE;
+			src += WORD_SIZE;
+		}
+	}
+
+	while (size--)
+		*dst++ = *src++;
+}
+
+
+/*
+ * Copy towards lower addresses, starting from the end of both buffers. Used
+ * when dst overlaps the tail of src
+ */
+static void memmove_backward(unsigned char *dst, const unsigned char *src, size_t size)
+{
+	dst += size;
+	src += size;
+
+	while (size && !WORD_ALIGNED(dst)) {
+		*--dst = *--src;
+		size--;
+	}
+
+	if (WORD_UNALIGNED_OK || WORD_ALIGNED(src)) {
+		for (; size >= WORD_SIZE; size -= WORD_SIZE) {
+			dst -= WORD_SIZE;
+			src -= WORD_SIZE;
+			*(word_t *) dst = *(const word_t *) src;
+		}
+	}
+
+	while (size--)
+		*--dst = *--src;
+}
+
+
 void* memmove(void* dstptr, const void* srcptr, size_t size) {
 	unsigned char* dst = (unsigned char*) dstptr;
 	const unsigned char* src = (const unsigned char*) srcptr;
-	if (dst < src) {
-		for (size_t i = 0; i < size; i++)
-			dst[i] = src[i];
+
+	if (dst == src || 0 == size)
+		return dstptr;
+
+	if (dst < src || dst >= src + size) {
+#if defined(__i386__)
+		/* rep movsd walks forward one element at a time, so dst < src is safe */
+		if (size >= STRING_REP_THRESHOLD) {
+			memcpy_rep(dstptr, srcptr, size);
+			return dstptr;
+		}
+#endif
+		memmove_forward(dst, src, size);
 	} else {
-		for (size_t i = size; i != 0; i--)
-			dst[i-1] = src[i-1];
+		memmove_backward(dst, src, size);
 	}
+
 	return dstptr;
 }
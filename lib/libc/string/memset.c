@@ -1,8 +1,50 @@
 #include <string.h>
- 
-void* memset(void* bufptr, int value, size_t size) {
-	unsigned char* buf = (unsigned char*) bufptr;
-	for (size_t i = 0; i < size; i++)
-		buf[i] = (unsigned char) value;
+#include <libc/string_impl.h>
+
+
+void *memset_words(void *bufptr, int value, size_t size)
+{
+	unsigned char *buf = (unsigned char *) bufptr;
+	word_t pattern = WORD_REPEAT(value);
+	word_t *wbuf;
+
+	/* Head: fill bytes until the buffer is word aligned */
+	while (size && !WORD_ALIGNED(buf)) {
+		*buf++ = (unsigned char) value;
+		size--;
+	}
+
+	wbuf = (word_t *) buf;
+	for (; size >= 4*WORD_SIZE; size -= 4*WORD_SIZE) {
+		wbuf[0] = pattern;
+		wbuf[1] = pattern;
+		wbuf[2] = pattern;
+		wbuf[3] = pattern;
+		wbuf += 4;
+	}
+
+	for (; size >= WORD_SIZE; size -= WORD_SIZE)
+		*wbuf++ = pattern;
+
+	/* Tail */
+	buf = (unsigned char *) wbuf;
+	while (size--)
+		*buf++ = (unsigned char) value;
+
 	return bufptr;
 }
+
+
+void *memset_scalar(void *bufptr, int value, size_t size)
+{
+#if defined(__i386__)
+	if (size >= STRING_REP_THRESHOLD)
+		return memset_rep(bufptr, value, size);
+#endif
+	return memset_words(bufptr, value, size);
+}
+
+
+void* memset(void* bufptr, int value, size_t size) {
+	return g_string_ops.memset(bufptr, value, size);
+}
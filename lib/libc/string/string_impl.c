@@ -0,0 +1,47 @@
+#include <string.h>
+#include <libc/string_impl.h>
+
+
+/* Start out with the portable routines; these are safe on any CPU */
+struct string_ops g_string_ops = {
+	.memcpy = memcpy_scalar,
+	.memset = memset_scalar,
+	.memcmp = memcmp_scalar,
+	.strlen = strlen_scalar,
+};
+
+
+void string_impl_init(unsigned int features)
+{
+	/*
+	 * Assign member by member: a struct copy may itself be lowered to a
+	 * memcpy() call through the table being rewritten
+	 */
+	struct string_ops *ops = &g_string_ops;
+
+	ops->memcpy = memcpy_scalar;
+	ops->memset = memset_scalar;
+	ops->memcmp = memcmp_scalar;
+	ops->strlen = strlen_scalar;
+
+#if defined(__i386__)
+	/*
+	 * Where both are present, ERMS wins for bulk copies and fills: rep movsb
+	 * needs no vector state and the microcode already moves full lines. SSE2
+	 * is only used for the routines that rep-strings cannot express
+	 */
+	if (features & STRING_FEAT_SSE2) {
+		ops->memcpy = memcpy_sse2;
+		ops->memset = memset_sse2;
+		ops->memcmp = memcmp_sse2;
+		ops->strlen = strlen_sse2;
+	}
+
+	if (features & STRING_FEAT_ERMS) {
+		ops->memcpy = memcpy_erms;
+		ops->memset = memset_erms;
+	}
+#else
+	(void) features;
+#endif
+}
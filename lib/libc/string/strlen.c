@@ -1,8 +1,25 @@
 #include <string.h>
+#include <libc/string_impl.h>
  
+size_t strlen_scalar(const char* str) {
+	const char* p = str;
+	const word_t* w;
+	word_t zero;
+
+	/* Walk bytewise up to a word boundary; aligned loads never cross a page */
+	while (!WORD_ALIGNED(p)) {
+		if (!*p)
+			return p - str;
+		p++;
+	}
+
+	for (w = (const word_t*) p; !(zero = WORD_HAS_ZERO(*w)); w++)
+		;
+
+	return ((const char*) w - str) + WORD_ZERO_INDEX(zero);
+}
+
+
 size_t strlen(const char* str) {
-	size_t len = 0;
-	while (str[len])
-		len++;
-	return len;
+	return g_string_ops.strlen(str);
 }
@@ -3,6 +3,10 @@
  */
 
 #include <string.h>
+#include <libc/string_impl.h>
+
+/* A word may be loaded from a string if the load cannot fault past its end */
+#define WORD_LOAD_OK(p)	(WORD_ALIGNED(p) || (WORD_UNALIGNED_OK && WORD_IN_PAGE(p)))
 
 int strncmp(const char *s1, const char *s2, size_t n)
 {
@@ -11,10 +15,32 @@ int strncmp(const char *s1, const char *s2, size_t n)
 	unsigned char ch;
 	int d = 0;
 
-	while (n--) {
+	while (n) {
+		if (n >= WORD_SIZE && WORD_LOAD_OK(c1) && WORD_LOAD_OK(c2)) {
+			word_t w1 = *(const word_t *)c1;
+			word_t w2 = *(const word_t *)c2;
+
+			/*
+			 * The lowest flagged byte is the first that either differs or
+			 * terminates s1; the comparison is decided there
+			 */
+			word_t stop = (w1 ^ w2) | WORD_HAS_ZERO(w1);
+
+			if (stop) {
+				size_t i = WORD_ZERO_INDEX(stop);
+				return (int)c1[i] - (int)c2[i];
+			}
+
+			c1 += WORD_SIZE;
+			c2 += WORD_SIZE;
+			n -= WORD_SIZE;
+			continue;
+		}
+
 		d = (int)(ch = *c1++) - (int)*c2++;
 		if (d || !ch)
 			break;
+		n--;
 	}
 
 	return d;
@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <kernel/printk.h>
 #include <multiboot/multiboot.h>
+#include <arch/page.h>
+#include <kernel/init.h>
 
 #define CHECK_FLAG(flags,bit)   ((flags) & (1 << (bit)))
 
@@ -9,7 +11,7 @@
  * @param mbi   : Multiboot structure to check
  * @return      : -1 on failure
  */
-int mb_check_valid(struct multiboot_info *mbi)
+int __init mb_check_valid(struct multiboot_info *mbi)
 {
     /* Print out the flags. */
     printk("flags = 0x%x\n", (unsigned) mbi->flags);
@@ -25,7 +27,7 @@ int mb_check_valid(struct multiboot_info *mbi)
 
     /* Is the command line passed? */
     if (CHECK_FLAG (mbi->flags, 2))
-        printk("cmdline = %s\n", (char *) mbi->cmdline);
+        printk("cmdline = %s\n", (char *) __va(mbi->cmdline));
 
     /* Are mods_* valid? */
     if (CHECK_FLAG (mbi->flags, 3)) {
@@ -34,13 +36,13 @@ int mb_check_valid(struct multiboot_info *mbi)
 
         printk("mods_count = %d, mods_addr = 0x%x\n",
                 (int) mbi->mods_count, (int) mbi->mods_addr);
-        for (i = 0, mod = (multiboot_module_t *) mbi->mods_addr;
+        for (i = 0, mod = (multiboot_module_t *) __va(mbi->mods_addr);
                 i < (int) mbi->mods_count;
                 i++, mod++)
             printk(" mod_start = 0x%x, mod_end = 0x%x, cmdline = %s\n",
                     (unsigned) mod->mod_start,
                     (unsigned) mod->mod_end,
-                    (char *) mod->cmdline);
+                    (char *) __va(mod->cmdline));
     }
 
     /* Bits 4 and 5 are mutually exclusive! */
@@ -78,9 +80,9 @@ int mb_check_valid(struct multiboot_info *mbi)
                 (unsigned) mbi->mmap_addr, (unsigned) mbi->mmap_length);
 
         printk("Memory map:\n");
-        mmap = (multiboot_memory_map_t *) mbi->mmap_addr;
-        for (; (uintptr_t) mmap < mbi->mmap_addr + mbi->mmap_length; 
-                mmap = (multiboot_memory_map_t *) ((unsigned long) mmap + sizeof(multiboot_memory_map_t))){
+        mmap = (multiboot_memory_map_t *) __va(mbi->mmap_addr);
+        for (; (uintptr_t) mmap < (uintptr_t) __va(mbi->mmap_addr + mbi->mmap_length); 
+                mmap = (multiboot_memory_map_t *) ((unsigned long) mmap + mmap->size + sizeof(mmap->size))){
 
             printk("\tbase = 0x%x%x, len = 0x%x%x, type = %s\n",
                 (uint32_t) (mmap->addr >> 32),
@@ -95,7 +97,22 @@ int mb_check_valid(struct multiboot_info *mbi)
 }
 
 
-int mb_init(struct multiboot_info *mbi, uint32_t magic)
+void __init mb_mmap_foreach(struct multiboot_info *mbi, mb_mmap_fn_t fn, void *ctx)
+{
+    multiboot_memory_map_t *mmap;
+
+    if (!CHECK_FLAG (mbi->flags, 6))
+        return;
+
+    /* Entries are variable-length; 'size' does not count the size field itself */
+    for (mmap = (multiboot_memory_map_t *) __va(mbi->mmap_addr);
+            (uintptr_t) mmap < (uintptr_t) __va(mbi->mmap_addr + mbi->mmap_length);
+            mmap = (multiboot_memory_map_t *) ((unsigned long) mmap + mmap->size + sizeof(mmap->size)))
+        fn(mmap->addr, mmap->len, mmap->type, ctx);
+}
+
+
+int __init mb_init(struct multiboot_info *mbi, uint32_t magic)
 {
     /* Sanity check before proceeding */
     if(MULTIBOOT_BOOTLOADER_MAGIC != magic)
@@ -3,6 +3,11 @@
 #include <multiboot/multiboot.h>
 #include <arch/descriptor.h>
 #include <arch/irq.h>
+#include <arch/cpu.h>
+#include <arch/mm.h>
+#include <kernel/slab.h>
+#include <kernel/softirq.h>
+#include <kernel/timer.h>
 
 
 /* Instance of the global platform structure */
@@ -13,6 +18,10 @@ void x86_boot_legacy(struct multiboot_info* mbi, uint32_t magic)
 {
     early_console_init();
 
+    /* Identify the CPU and bind the string routines before anything heavy runs */
+    cpu_detect();
+    cpu_string_init();
+
     if(0 != mb_init(mbi, magic)){
         printk("The Multiboot header failed validation!\n");
         abort();
@@ -21,9 +30,19 @@ void x86_boot_legacy(struct multiboot_info* mbi, uint32_t magic)
     /* Install the default GDT and IDT */
     gdt_setup();
     idt_setup();
+
+    /* Hand usable RAM to the page allocator, switch to the kernel page tables and bring up kmalloc() */
+    x86_memory_init(mbi);
+    slab_init();
     
     /* Initialize the interrupt subsystem; returns with interrupts disabled */
     irq_init();
+    softirq_init();
+    timer_init();
+
+    /* Device handlers; each unmasks its line as it registers */
+    time_init();
+    keyboard_init();
 
     /* Jump to the kernel proper's main entry point */
     kernel_main();
@@ -6,6 +6,12 @@
 .set FLAGS,                 (BOOT_MODULES_ALIGNED | MEMINFO | VIDEOINFO)
 .set CHECKSUM,              -(MAGIC + FLAGS)
 
+# Must match PAGE_OFFSET and BOOT_MAP_SIZE in arch/page.h
+.set KERNEL_VIRT_BASE,      0xC0000000
+.set BOOT_PGTABLES,         4               # Each table maps 4 MiB
+.set PTE_PRESENT_RW,        0x003
+.set CR0_PG_WP,             0x80010000
+
 .extern __stack
 .extern exit_panic 
 .extern x86_boot_legacy # Extern to be seen from _this_ file at link-time
@@ -23,13 +29,57 @@
  * Per the spec
  *  - eax contains an adjusted magic
  *  - ebc contains a 32-bit pointer to the multiboot information structure
+ *
+ * The kernel is linked at KERNEL_VIRT_BASE but loaded at its physical address
+ * with paging off. This trampoline is linked low, so it runs where it was
+ * loaded; it maps the first BOOT_PGTABLES*4 MiB of physical memory both at 0
+ * and at KERNEL_VIRT_BASE, enables paging and jumps into the high half. The
+ * identity half of the mapping is discarded once paging_init() builds the
+ * real kernel page tables
  */
-.section .text
+.section .boot.text, "ax"
 kernel_loader:
+    cli             # Disable interrupts
+    cld
+    mov esi, eax    # Keep the magic; eax/ecx/edi are used below
+
+    # Page tables: consecutive frames from physical 0
+    mov edi, offset boot_pgtables - KERNEL_VIRT_BASE
+    mov eax, PTE_PRESENT_RW
+    mov ecx, 1024 * BOOT_PGTABLES
+1:
+    stosd
+    add eax, 0x1000
+    loop 1b
+
+    # Directory: the same tables at index 0 and at KERNEL_VIRT_BASE
+    mov edi, offset boot_pgdir - KERNEL_VIRT_BASE
+    mov eax, offset boot_pgtables - KERNEL_VIRT_BASE + PTE_PRESENT_RW
+    mov ecx, BOOT_PGTABLES
+2:
+    mov [edi], eax
+    mov [edi + (KERNEL_VIRT_BASE >> 22) * 4], eax
+    add eax, 0x1000
+    add edi, 4
+    loop 2b
+
+    mov eax, offset boot_pgdir - KERNEL_VIRT_BASE
+    mov cr3, eax
+    mov eax, cr0
+    or eax, CR0_PG_WP
+    mov cr0, eax
+
+    # Absolute jump to the high mapping
+    lea eax, kernel_high
+    jmp eax
+
+
+.section .text
+kernel_high:
     lea esp, __stack
-    push eax
+    add ebx, KERNEL_VIRT_BASE   # The multiboot structure, seen through the high mapping
+    push esi
     push ebx
-    cli             # Disable interrupts
     call x86_boot_legacy 
 
 _exit_loop:
@@ -39,4 +89,10 @@ _exit_loop:
     jmp _exit_loop
 
 
-.section .bss
+# Dead once paging_init() switches CR3; freed with the rest of the init sections
+.section .init.data, "aw"
+.align 4096
+boot_pgdir:
+    .skip 4096
+boot_pgtables:
+    .skip 4096 * BOOT_PGTABLES
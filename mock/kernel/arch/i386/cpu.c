@@ -0,0 +1,121 @@
+#include <mock.h>
+#include <arch/cpu.h>
+#include <libc/string_impl.h>
+#include <kernel/init.h>
+
+
+struct cpu_info g_cpu_info = {0};
+
+
+/*
+ * CPUID is available iff the ID bit (21) in EFLAGS can be toggled
+ */
+static int __init cpuid_supported(void)
+{
+    uint32_t before, after;
+
+    asm volatile("pushfl                \n\t"
+                 "pushfl                \n\t"
+                 "popl %0               \n\t"
+                 "movl %0, %1           \n\t"
+                 "xorl $0x200000, %1    \n\t"
+                 "pushl %1              \n\t"
+                 "popfl                 \n\t"
+                 "pushfl                \n\t"
+                 "popl %1               \n\t"
+                 "popfl                 \n\t"
+                 : "=&r"(before), "=&r"(after));
+
+    return 0 != ((before ^ after) & 0x200000);
+}
+
+
+void __init cpu_detect(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    struct cpu_info *c = &g_cpu_info;
+
+    if(!cpuid_supported()){
+        printk("CPU: No CPUID support\n");
+        return;
+    }
+
+    c->cpuid_available = 1;
+
+    /* Leaf 0: maximum standard leaf and the vendor string (ebx, edx, ecx) */
+    cpuid(0, &c->max_leaf, &ebx, &ecx, &edx);
+    memcpy(&c->vendor[0], &ebx, 4);
+    memcpy(&c->vendor[4], &edx, 4);
+    memcpy(&c->vendor[8], &ecx, 4);
+    c->vendor[12] = '\0';
+
+    if(c->max_leaf >= 1){
+        cpuid(1, &eax, &ebx, &ecx, &edx);
+        c->stepping = eax & 0xf;
+        c->model = (eax >> 4) & 0xf;
+        c->family = (eax >> 8) & 0xf;
+
+        /* The extended family/model fields only apply to certain base families */
+        if(0xf == c->family)
+            c->family += (eax >> 20) & 0xff;
+        if(0x6 == c->family || 0xf <= c->family)
+            c->model |= ((eax >> 16) & 0xf) << 4;
+
+        c->features[CPUID_1_EDX] = edx;
+        c->features[CPUID_1_ECX] = ecx;
+    }
+
+    if(c->max_leaf >= 7){
+        cpuid_count(7, 0, &eax, &ebx, &ecx, &edx);
+        c->features[CPUID_7_0_EBX] = ebx;
+    }
+
+    cpuid(0x80000000, &c->max_ext_leaf, &ebx, &ecx, &edx);
+    if(c->max_ext_leaf >= 0x80000001){
+        cpuid(0x80000001, &eax, &ebx, &ecx, &edx);
+        c->features[CPUID_80000001_EDX] = edx;
+    }
+
+    if(c->max_ext_leaf >= 0x80000007){
+        cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+        c->features[CPUID_80000007_EDX] = edx;
+    }
+
+    printk("CPU: %s family=0x%x model=0x%x stepping=0x%x\n",
+            c->vendor, c->family, c->model, c->stepping);
+}
+
+
+/*
+ * SSE instructions fault with #UD until the OS advertises FXSAVE/FXRSTOR
+ * support through CR4, and with #NM while CR0.EM or CR0.TS are set
+ */
+static int __init cpu_enable_sse(void)
+{
+    if(!cpu_has(CPU_FEATURE_FXSR) || !cpu_has(CPU_FEATURE_SSE2))
+        return 0;
+
+    write_cr0((read_cr0() & ~(CR0_EM | CR0_TS)) | CR0_MP);
+    write_cr4(read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT);
+
+    return 1;
+}
+
+
+void __init cpu_string_init(void)
+{
+    unsigned int features = 0;
+
+    if(cpu_has(CPU_FEATURE_ERMS))
+        features |= STRING_FEAT_ERMS;
+
+    if(cpu_enable_sse())
+        features |= STRING_FEAT_SSE2;
+
+    string_impl_init(features);
+
+    printk("CPU: string ops:%s%s%s\n",
+            (features & STRING_FEAT_SSE2) ? " sse2" : "",
+            (features & STRING_FEAT_ERMS) ? " erms" : "",
+            (0 == features) ? " scalar" : "");
+}
@@ -3,6 +3,7 @@
 #include <arch/irq.h>
 
 #include <arch/io.h>
+#include <kernel/init.h>
 
 
 /*
@@ -46,7 +47,7 @@ void load_segments(uint16_t seg_code, uint16_t seg_data)
 }
 
 
-void gdt_setup(void)
+void __init gdt_setup(void)
 {
     g_pm_tables.gdt[0] = GDT_DESCRIPTOR_ENTRY(0,0,0);                      /* First required empty/null descriptor for error detection */
     g_pm_tables.gdt[1] = GDT_DESCRIPTOR_ENTRY(0, 0xfffff, (GDT_CODE_PL0)); /* Next two entries are for kernel space; DPL=0 */
@@ -94,7 +95,7 @@ int gdt_get_slot(int slot, struct segment_desc *dst)
 }
 
 
-void idt_setup(void)
+void __init idt_setup(void)
 {
     /* Construct the initial IDT with entries all pointing to the default handler */
     for(int i=0; i<(int) (sizeof(g_pm_tables.idt)/sizeof(struct gate_desc)); i++){
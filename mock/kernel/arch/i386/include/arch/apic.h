@@ -0,0 +1,143 @@
+#ifndef _ARCH_X86_APIC_H
+#define _ARCH_X86_APIC_H
+
+#include <stdint.h>
+#include <kern_return.h>
+#include <irq.h>
+
+
+/*
+ * Local APIC register offsets (xAPIC, memory mapped). In x2APIC mode the
+ * same register lives in MSR X2APIC_MSR_BASE + offset/16
+ */
+#define LAPIC_ID                0x020
+#define LAPIC_VERSION           0x030
+#define LAPIC_TPR               0x080
+#define LAPIC_EOI               0x0B0
+#define LAPIC_SVR               0x0F0
+#define LAPIC_ESR               0x280
+#define LAPIC_ICR_LOW           0x300
+#define LAPIC_ICR_HIGH          0x310
+#define LAPIC_LVT_TIMER         0x320
+#define LAPIC_LVT_LINT0         0x350
+#define LAPIC_LVT_LINT1         0x360
+#define LAPIC_LVT_ERROR         0x370
+#define LAPIC_TIMER_INITIAL     0x380
+#define LAPIC_TIMER_CURRENT     0x390
+#define LAPIC_TIMER_DIVIDE      0x3E0
+
+#define X2APIC_MSR_BASE         0x800
+
+#define LAPIC_SVR_ENABLE        (1 << 8)
+#define LAPIC_LVT_MASKED        (1 << 16)
+#define LAPIC_LVT_DM_NMI        (4 << 8)
+#define LAPIC_LVT_TIMER_TSC_DEADLINE (2 << 17)
+
+/* Interrupt command register, low dword */
+#define LAPIC_ICR_DM_FIXED      (0 << 8)
+#define LAPIC_ICR_DM_NMI        (4 << 8)
+#define LAPIC_ICR_DM_INIT       (5 << 8)
+#define LAPIC_ICR_DM_STARTUP    (6 << 8)
+#define LAPIC_ICR_BUSY          (1 << 12)   /* xAPIC only */
+#define LAPIC_ICR_ASSERT        (1 << 14)
+#define LAPIC_ICR_DEST_SELF     (1 << 18)
+#define LAPIC_ICR_DEST_ALL_BUT_SELF (3 << 18)
+
+/* Local APIC timer */
+#define LAPIC_TIMER_VECTOR      0xEF
+
+/* Spurious interrupts are delivered here and must not be acknowledged */
+#define LAPIC_SPURIOUS_VECTOR   0xFF
+
+/* IOAPIC: an index register and a data window */
+#define IOAPIC_REGSEL           0x00
+#define IOAPIC_WINDOW           0x10
+
+#define IOAPIC_REG_ID           0x00
+#define IOAPIC_REG_VERSION      0x01
+#define IOAPIC_REG_REDTBL(n)    (0x10 + 2*(n))
+
+/* Redirection table entry, low dword */
+#define IOAPIC_RTE_POLARITY_LOW (1 << 13)
+#define IOAPIC_RTE_TRIGGER_LEVEL (1 << 15)
+#define IOAPIC_RTE_MASKED       (1 << 16)
+/* High dword */
+#define IOAPIC_RTE_DEST_SHIFT   24
+
+
+/*
+ * Look for a usable local APIC and IOAPIC through the ACPI MADT
+ * @return  : KERN_SUCCESS if the APIC backend can be used
+ */
+kern_return_t apic_probe(void);
+
+
+/*
+ * Take over interrupt delivery from the 8259: mask and remap the PICs, enable
+ * the local APIC and route every ISA IRQ (masked) to IRQ_VECTOR_BASE + irq
+ */
+void apic_init(void);
+
+
+/*
+ * Whether apic_init() has taken over interrupt delivery
+ */
+int apic_enabled(void);
+
+
+/*
+ * Signal end-of-interrupt to the local APIC; a single MMIO or MSR write
+ */
+void apic_eoi(unsigned int vector);
+
+
+/*
+ * Local APIC register access, through MMIO or MSRs depending on the mode the
+ * APIC was brought up in
+ *
+ * @param reg   : xAPIC register offset, e.g. LAPIC_TIMER_INITIAL
+ */
+uint32_t lapic_read(uint32_t reg);
+void lapic_write(uint32_t reg, uint32_t value);
+
+
+/*
+ * ID of the local APIC of the calling CPU; the full 32 bits in x2APIC mode
+ */
+uint32_t lapic_id(void);
+
+
+/*
+ * Send an inter-processor interrupt
+ *
+ * @param dest  : Destination APIC ID; ignored with a destination shorthand
+ * @param cmd   : Vector and LAPIC_ICR_* delivery/shorthand bits
+ */
+void lapic_send_ipi(uint32_t dest, uint32_t cmd);
+
+
+/* ISA IRQ masking through the IOAPIC; same semantics as the 8259 routines */
+void ioapic_mask_irq(irq_t irq);
+void ioapic_unmask_irq(irq_t irq);
+void ioapic_setmask(irq_t mask);
+
+
+/*
+ * Route an ISA IRQ to one CPU; 'cpu' indexes the processors in MADT order
+ */
+kern_return_t ioapic_set_target(irq_t irq, unsigned int cpu);
+
+
+/*
+ * CPUs that can currently take device interrupts, one bit per MADT index.
+ * Only the boot CPU until others are brought up and call apic_cpu_online()
+ */
+uint32_t apic_cpu_mask(void);
+void apic_cpu_online(unsigned int cpu);
+
+
+/* Entry stub for the spurious vector (apic_asm.S) */
+void lapic_spurious_entry(void);
+
+
+#endif /* _ARCH_X86_APIC_H */
@@ -0,0 +1,161 @@
+#ifndef _ARCH_X86_CPU_H
+#define _ARCH_X86_CPU_H
+
+#include <stdint.h>
+
+
+/*
+ * The CPUID leaves/registers we cache, one 32-bit word each. A feature is
+ * named by its word index and bit position within that word
+ */
+enum cpuid_word {
+    CPUID_1_EDX = 0,
+    CPUID_1_ECX,
+    CPUID_7_0_EBX,
+    CPUID_80000001_EDX,
+    CPUID_80000007_EDX,
+    CPUID_NR_WORDS
+};
+
+#define CPU_FEATURE(word, bit)      ((word) * 32 + (bit))
+
+/* CPUID.1:EDX */
+#define CPU_FEATURE_FPU             CPU_FEATURE(CPUID_1_EDX, 0)
+#define CPU_FEATURE_PSE             CPU_FEATURE(CPUID_1_EDX, 3)
+#define CPU_FEATURE_TSC             CPU_FEATURE(CPUID_1_EDX, 4)
+#define CPU_FEATURE_MSR             CPU_FEATURE(CPUID_1_EDX, 5)
+#define CPU_FEATURE_PAE             CPU_FEATURE(CPUID_1_EDX, 6)
+#define CPU_FEATURE_APIC            CPU_FEATURE(CPUID_1_EDX, 9)
+#define CPU_FEATURE_PGE             CPU_FEATURE(CPUID_1_EDX, 13)
+#define CPU_FEATURE_FXSR            CPU_FEATURE(CPUID_1_EDX, 24)
+#define CPU_FEATURE_SSE             CPU_FEATURE(CPUID_1_EDX, 25)
+#define CPU_FEATURE_SSE2            CPU_FEATURE(CPUID_1_EDX, 26)
+
+/* CPUID.1:ECX */
+#define CPU_FEATURE_SSE3            CPU_FEATURE(CPUID_1_ECX, 0)
+#define CPU_FEATURE_X2APIC          CPU_FEATURE(CPUID_1_ECX, 21)
+#define CPU_FEATURE_TSC_DEADLINE    CPU_FEATURE(CPUID_1_ECX, 24)
+
+/* CPUID.(EAX=7,ECX=0):EBX */
+#define CPU_FEATURE_ERMS            CPU_FEATURE(CPUID_7_0_EBX, 9)
+
+/* CPUID.80000001:EDX */
+#define CPU_FEATURE_NX              CPU_FEATURE(CPUID_80000001_EDX, 20)
+
+/* CPUID.80000007:EDX */
+#define CPU_FEATURE_INVARIANT_TSC   CPU_FEATURE(CPUID_80000007_EDX, 8)
+
+
+/*
+ * Boot CPU identification, filled in once by cpu_detect()
+ */
+struct cpu_info {
+    int cpuid_available;
+    uint32_t max_leaf;
+    uint32_t max_ext_leaf;
+    char vendor[13];
+    unsigned int family;                /* Base plus extended; up to 0x10e */
+    unsigned int model;
+    uint8_t stepping;
+    uint32_t features[CPUID_NR_WORDS];
+};
+
+extern struct cpu_info g_cpu_info;
+
+
+/* Control register bits we care about */
+#define CR0_MP          (1 << 1)
+#define CR0_EM          (1 << 2)
+#define CR0_TS          (1 << 3)
+#define CR0_WP          (1 << 16)
+#define CR0_PG          (1u << 31)
+
+#define CR4_PSE         (1 << 4)
+#define CR4_PGE         (1 << 7)
+#define CR4_OSFXSR      (1 << 9)
+#define CR4_OSXMMEXCPT  (1 << 10)
+
+
+/* Model specific registers */
+#define MSR_IA32_APIC_BASE      0x1B
+#define APIC_BASE_BSP           (1 << 8)
+#define APIC_BASE_X2APIC        (1 << 10)
+#define APIC_BASE_ENABLE        (1 << 11)
+#define APIC_BASE_ADDR_MASK     0xFFFFF000u
+
+
+static inline uint64_t rdmsr(uint32_t msr)
+{
+    uint32_t lo, hi;
+    asm volatile("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+    return ((uint64_t) hi << 32) | lo;
+}
+
+
+static inline void wrmsr(uint32_t msr, uint64_t value)
+{
+    asm volatile("wrmsr" : : "c"(msr), "a"((uint32_t) value), "d"((uint32_t) (value >> 32)) : "memory");
+}
+
+
+static inline uint64_t rdtsc(void)
+{
+    uint32_t lo, hi;
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t) hi << 32) | lo;
+}
+
+
+static inline void cpuid_count(uint32_t leaf, uint32_t subleaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx)
+{
+    asm volatile("cpuid"
+                 : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                 : "a"(leaf), "c"(subleaf));
+}
+
+
+static inline void cpuid(uint32_t leaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx)
+{
+    cpuid_count(leaf, 0, eax, ebx, ecx, edx);
+}
+
+
+static inline int cpu_has(unsigned int feature)
+{
+    return (g_cpu_info.features[feature / 32] >> (feature % 32)) & 1;
+}
+
+
+#define CREATE_CR_FUNC(n)                                   \
+static inline uint32_t read_cr##n(void)                     \
+{                                                           \
+    uint32_t value;                                         \
+    asm volatile("mov %%cr" #n ", %0" : "=r"(value));       \
+    return value;                                           \
+}                                                           \
+                                                            \
+static inline void write_cr##n(uint32_t value)              \
+{                                                           \
+    asm volatile("mov %0, %%cr" #n : : "r"(value) : "memory"); \
+}                                                           \
+
+CREATE_CR_FUNC(0)
+CREATE_CR_FUNC(2)
+CREATE_CR_FUNC(3)
+CREATE_CR_FUNC(4)
+
+
+/*
+ * Identify the boot CPU and populate g_cpu_info from CPUID
+ */
+void cpu_detect(void);
+
+
+/*
+ * Enable the CPU extensions the kernel relies on (e.g. SSE) and bind the
+ * libc string routines to the fastest implementation this CPU supports
+ */
+void cpu_string_init(void);
+
+
+#endif /* _ARCH_X86_CPU_H */
@@ -2,6 +2,7 @@
 #define _ARCH_X86_IRQ_H
 
 #include <stdint.h>
+#include <irq.h>
 #include "irq/time.h"
 #include "irq/cmos.h"
 #include "irq/keyboard.h"
@@ -10,7 +11,49 @@
 /* 
  * The default interrupt handler vector 
  */
-irq_handler_t *g_int_default_vect;
+extern irq_handler_t *g_int_default_vect;
+
+/*
+ * ISA IRQ n is delivered on vector IRQ_VECTOR_BASE + n, whichever interrupt
+ * controller is in use; this keeps them clear of the CPU exceptions
+ */
+#define IRQ_VECTOR_BASE     0x20
+#define ISA_NR_IRQS         16
+
+#define NR_VECTORS          256
+#define NR_IRQS             ISA_NR_IRQS
+
+
+static inline unsigned int irq_to_vector(irq_t irq)
+{
+    return IRQ_VECTOR_BASE + irq;
+}
+
+
+/*
+ * Interrupted state as saved by the common entry stub in default_handler.S,
+ * lowest address first
+ */
+struct irq_frame {
+    /* pushad */
+    uint32_t edi;
+    uint32_t esi;
+    uint32_t ebp;
+    uint32_t esp;               /* Value before pushad; not restored */
+    uint32_t ebx;
+    uint32_t edx;
+    uint32_t ecx;
+    uint32_t eax;
+
+    /* Pushed by the vector's stub */
+    uint32_t vector;
+    uint32_t error_code;        /* Zero for vectors without a CPU error code */
+
+    /* Pushed by the CPU */
+    uint32_t eip;
+    uint32_t cs;
+    uint32_t eflags;
+} __attribute__((packed));
 
 /*
  * Enumeration of the types of interrupt controller 
@@ -57,4 +100,26 @@ enum x86_pm_exceptions {
 void irq_init(void);
 
 
+/*
+ * C entry point for every vector, called from the common entry stub
+ */
+void irq_common_handler(struct irq_frame *frame);
+
+
+/*
+ * Acknowledge the interrupt being serviced at the active controller. Called
+ * from the interrupt entry stubs
+ *
+ * @param vector    : The vector that was raised
+ */
+#ifdef IRQ_BACKEND_STATIC
+static inline void irq_eoi(unsigned int vector)
+{
+    arch_irq_eoi(vector);
+}
+#else
+void irq_eoi(unsigned int vector);
+#endif
+
+
 #endif /* _ARCH_X86_IRQ_H */
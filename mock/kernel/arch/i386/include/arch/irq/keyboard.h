@@ -1,9 +1,42 @@
 #ifndef _ARCH_KEYBOARD_H
 #define _ARCH_KEYBOARD_H
 
+#include <stdint.h>
 
-void kb_handler_entry(void);
 
+/* Modifier state carried by every event */
+#define KB_MOD_SHIFT        (1 << 0)
+#define KB_MOD_CTRL         (1 << 1)
+#define KB_MOD_ALT          (1 << 2)
+#define KB_MOD_CAPSLOCK     (1 << 3)
 
-#endif /* _ARCH_KEYBOARD_H */
+/* Extended (0xE0-prefixed) keys have this bit set in their keycode */
+#define KB_KEY_EXTENDED     0x100
+
+/* Keycodes of keys with no ASCII translation */
+#define KB_KEY_F1           0x3b
+
+struct kb_event {
+    uint16_t keycode;       /* Scancode set 1 make code, possibly KB_KEY_EXTENDED */
+    uint8_t pressed;        /* 1 on make, 0 on break */
+    uint8_t modifiers;      /* KB_MOD_* after this event was applied */
+    char ascii;             /* Translated character, or 0 if the key has none */
+};
+
+
+/*
+ * Register the PS/2 keyboard handler on IRQ1
+ */
+void keyboard_init(void);
 
+
+/*
+ * Fetch the next decoded key event without blocking
+ *
+ * @param ev : Filled in with the event
+ * @return   : 1 if an event was returned, 0 if none is pending
+ */
+int keyboard_read_event(struct kb_event *ev);
+
+
+#endif /* _ARCH_KEYBOARD_H */
@@ -1,8 +1,39 @@
 #ifndef _ARCH_TIME_H
 #define _ARCH_TIME_H
 
+#include <stdint.h>
 
-void time_systick_handler(void);
+
+/*
+ * Start counting timer ticks on IRQ0 and set up the clocksources
+ */
+void time_init(void);
+
+
+/*
+ * Calibrate the TSC against the PIT and register it as a clocksource.
+ * Called by time_init()
+ */
+void tsc_init(void);
+
+
+/*
+ * Measured TSC frequency, or 0 if there is no usable TSC
+ */
+uint64_t tsc_get_hz(void);
+
+
+/*
+ * Use the local APIC timer in TSC-deadline mode for hrtimers, if the APIC
+ * is in use and the CPU has it. Called by time_init() once the TSC is known
+ */
+void lapic_timer_init(void);
+
+
+/*
+ * Busy-wait for at least 'msec' milliseconds
+ */
+void time_delay_msec(uint32_t msec);
 
 
 #endif /* _ARCH_TIME_H */
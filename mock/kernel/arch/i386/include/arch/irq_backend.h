@@ -0,0 +1,48 @@
+#ifndef _ARCH_X86_IRQ_BACKEND_H
+#define _ARCH_X86_IRQ_BACKEND_H
+
+/*
+ * Build-time choice of interrupt controller. By default the controller is
+ * probed at boot and every mask/EOI operation goes through the function
+ * pointers in struct platform. A kernel built with CONFIG_IRQ_BACKEND_PIC or
+ * CONFIG_IRQ_BACKEND_APIC instead binds them here, as direct calls the
+ * compiler can inline (see IRQ_BACKEND in arch/i386/Makefile)
+ *
+ * Only include this through <irq.h>
+ */
+
+#if defined(CONFIG_IRQ_BACKEND_PIC) && defined(CONFIG_IRQ_BACKEND_APIC)
+#error "Select at most one of CONFIG_IRQ_BACKEND_PIC and CONFIG_IRQ_BACKEND_APIC"
+#endif
+
+
+#if defined(CONFIG_IRQ_BACKEND_PIC)
+
+#include <arch/pic8259.h>
+
+#define IRQ_BACKEND_STATIC
+
+static inline void arch_irq_enable(irq_t irq)           { pic8259_unmask_irq(irq); }
+static inline void arch_irq_disable(irq_t irq)          { pic8259_mask_irq(irq); }
+static inline void arch_irq_setmask(irq_t mask)         { pic8259_setmask(mask); }
+static inline void arch_irq_eoi(unsigned int vector)    { pic8259_eoi(vector); }
+static inline int arch_irq_spurious(unsigned int vector){ return pic8259_spurious(vector); }
+static inline void arch_irq_stats_dump(void)            { pic8259_stats_dump(); }
+
+#elif defined(CONFIG_IRQ_BACKEND_APIC)
+
+#include <arch/apic.h>
+
+#define IRQ_BACKEND_STATIC
+
+static inline void arch_irq_enable(irq_t irq)           { ioapic_unmask_irq(irq); }
+static inline void arch_irq_disable(irq_t irq)          { ioapic_mask_irq(irq); }
+static inline void arch_irq_setmask(irq_t mask)         { ioapic_setmask(mask); }
+static inline void arch_irq_eoi(unsigned int vector)    { apic_eoi(vector); }
+static inline int arch_irq_spurious(unsigned int vector){ (void) vector; return 0; }
+static inline void arch_irq_stats_dump(void)            { }
+
+#endif
+
+
+#endif /* _ARCH_X86_IRQ_BACKEND_H */
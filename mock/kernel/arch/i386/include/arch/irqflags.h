@@ -0,0 +1,48 @@
+#ifndef _ARCH_X86_IRQFLAGS_H
+#define _ARCH_X86_IRQFLAGS_H
+
+#include <stdint.h>
+
+
+#define X86_EFLAGS_IF   (1 << 9)
+
+
+/*
+ * Disable interrupts on the local CPU, returning the previous EFLAGS so the
+ * caller can restore the prior state (interrupts may already be disabled)
+ */
+static inline unsigned long local_irq_save(void)
+{
+    unsigned long flags;
+    asm volatile("pushfl; popl %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+
+static inline void local_irq_restore(unsigned long flags)
+{
+    asm volatile("pushl %0; popfl" : : "r"(flags) : "memory", "cc");
+}
+
+
+static inline void local_irq_enable(void)
+{
+    asm volatile("sti" : : : "memory");
+}
+
+
+static inline void local_irq_disable(void)
+{
+    asm volatile("cli" : : : "memory");
+}
+
+
+static inline int irqs_disabled(void)
+{
+    unsigned long flags;
+    asm volatile("pushfl; popl %0" : "=r"(flags));
+    return !(flags & X86_EFLAGS_IF);
+}
+
+
+#endif /* _ARCH_X86_IRQFLAGS_H */
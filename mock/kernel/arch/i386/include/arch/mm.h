@@ -0,0 +1,24 @@
+#ifndef _ARCH_X86_MM_H
+#define _ARCH_X86_MM_H
+
+#include <multiboot/multiboot.h>
+
+
+/* Section boundaries provided by linker.ld */
+extern char __kernel_start[];
+extern char __text_start[];
+extern char __text_end[];
+extern char __stacktop[];
+
+
+/*
+ * Bring up physical memory management from the bootloader's memory map and
+ * switch to the kernel page tables. Usable RAM, less the kernel image, the
+ * multiboot data and the first MiB, is handed to the page allocator
+ *
+ * @param mbi   : Multiboot structure passed to us from the bootloader
+ */
+void x86_memory_init(struct multiboot_info *mbi);
+
+
+#endif /* _ARCH_X86_MM_H */
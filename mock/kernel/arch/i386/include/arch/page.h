@@ -0,0 +1,35 @@
+#ifndef _ARCH_X86_PAGE_H
+#define _ARCH_X86_PAGE_H
+
+#include <stdint.h>
+
+
+#define PAGE_SHIFT          12
+#define PAGE_SIZE           (1u << PAGE_SHIFT)
+#define PAGE_MASK           (~(PAGE_SIZE - 1))
+
+#define PAGE_ALIGN_DOWN(x)  ((x) & PAGE_MASK)
+#define PAGE_ALIGN(x)       (((x) + PAGE_SIZE - 1) & PAGE_MASK)
+
+typedef uint32_t phys_addr_t;
+
+/*
+ * Virtual address at which physical memory is linearly mapped. The kernel
+ * image is linked inside this mapping, leaving the lower 3 GiB to user space
+ */
+#define PAGE_OFFSET         0xC0000000u
+
+/*
+ * Physical memory reachable through the direct map. The remainder of the top
+ * GiB is kept free for ioremap() and other special mappings
+ */
+#define DIRECT_MAP_SIZE     0x38000000u
+
+/* Physical memory mapped by the trampoline in loader.s before paging_init() */
+#define BOOT_MAP_SIZE       0x01000000u
+
+#define __pa(vaddr)         ((phys_addr_t) ((uintptr_t) (vaddr) - PAGE_OFFSET))
+#define __va(paddr)         ((void *) ((uintptr_t) (paddr) + PAGE_OFFSET))
+
+
+#endif /* _ARCH_X86_PAGE_H */
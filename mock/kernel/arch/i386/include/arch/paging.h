@@ -0,0 +1,112 @@
+#ifndef _ARCH_X86_PAGING_H
+#define _ARCH_X86_PAGING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <kern_return.h>
+#include <arch/page.h>
+
+
+/* Two-level, non-PAE paging: 1024 PDEs each covering 4 MiB */
+#define PGDIR_SHIFT         22
+#define PTRS_PER_PGDIR      1024
+#define PTRS_PER_PGTABLE    1024
+#define LARGE_PAGE_SIZE     (1u << PGDIR_SHIFT)
+#define LARGE_PAGE_MASK     (~(LARGE_PAGE_SIZE - 1))
+
+#define PGDIR_INDEX(va)     (((uint32_t) (va)) >> PGDIR_SHIFT)
+#define PGTABLE_INDEX(va)   ((((uint32_t) (va)) >> PAGE_SHIFT) & (PTRS_PER_PGTABLE - 1))
+
+/* Page directory and page table entry bits */
+#define PTE_PRESENT         (1 << 0)
+#define PTE_RW              (1 << 1)
+#define PTE_USER            (1 << 2)
+#define PTE_PWT             (1 << 3)
+#define PTE_PCD             (1 << 4)
+#define PTE_ACCESSED        (1 << 5)
+#define PTE_DIRTY           (1 << 6)
+#define PDE_LARGE           (1 << 7)    /* PDE maps a 4 MiB page (requires CR4.PSE) */
+#define PTE_GLOBAL          (1 << 8)    /* Survives CR3 reloads (requires CR4.PGE) */
+
+#define PTE_FLAGS_MASK      0xFFFu
+
+typedef uint32_t pde_t;
+typedef uint32_t pte_t;
+
+/* Virtual window above the direct map for ioremap() */
+#define IOREMAP_START       (PAGE_OFFSET + DIRECT_MAP_SIZE)
+#define IOREMAP_END         0xFFC00000u
+
+/* Flags for ordinary kernel memory */
+#define PAGE_KERNEL         (PTE_PRESENT | PTE_RW)
+#define PAGE_KERNEL_NOCACHE (PTE_PRESENT | PTE_RW | PTE_PCD | PTE_PWT)
+
+
+static inline void invlpg(uintptr_t va)
+{
+    asm volatile("invlpg (%0)" : : "r"(va) : "memory");
+}
+
+
+/*
+ * Bytes of page tables paging_init() needs to build the direct map; zero when
+ * the CPU supports 4 MiB pages
+ */
+size_t paging_early_size(uint32_t max_pfn);
+
+
+/*
+ * Build the kernel page tables and switch to them. All physical RAM up to
+ * g_max_pfn (at most DIRECT_MAP_SIZE) is mapped at __va() using 4 MiB pages
+ * where the CPU supports PSE, marked global where it supports PGE. The boot
+ * identity mapping is dropped
+ *
+ * @param early_tables : paging_early_size() bytes of reserved, boot-mapped memory
+ */
+void paging_init(phys_addr_t early_tables);
+
+
+/*
+ * Map a single 4 KiB page in the kernel page directory. A 4 MiB mapping that
+ * covers the address is split into a page table first
+ *
+ * @param va    : Page-aligned virtual address
+ * @param pa    : Page-aligned physical address
+ * @param flags : PTE_* bits for the new entry
+ * @return      : KERN_SUCCESS, or KERN_FAILURE if no page table could be allocated
+ */
+kern_return_t paging_map_page(uintptr_t va, phys_addr_t pa, uint32_t flags);
+
+
+/*
+ * Remove a 4 KiB mapping from the kernel page directory
+ */
+void paging_unmap_page(uintptr_t va);
+
+
+/*
+ * Translate a kernel virtual address through the live page tables
+ * @return      : The physical address, or 0 if it is not mapped
+ */
+phys_addr_t paging_virt_to_phys(uintptr_t va);
+
+
+/*
+ * Map device memory (or anything outside the direct map) uncached into the
+ * ioremap window. Virtual space is not recycled, so this is meant for
+ * long-lived mappings such as APIC registers
+ *
+ * @param pa    : Physical address; need not be page aligned
+ * @param size  : Length of the region in bytes
+ * @return      : Virtual address corresponding to pa, or NULL on failure
+ */
+void *ioremap(phys_addr_t pa, size_t size);
+
+
+/*
+ * Remove a mapping made by ioremap()
+ */
+void iounmap(void *va, size_t size);
+
+
+#endif /* _ARCH_X86_PAGING_H */
@@ -14,6 +14,9 @@
 #define PIC8259_SLAVE_CMD       0xa0
 #define PIC8259_SLAVE_DATA      0xa1
 
+/* Master input the slave's INT output is wired to */
+#define PIC8259_CASCADE_IRQ     2
+
 
 /* 
  * Apparently reading and writing to the PIC without regulation can introduce 
@@ -35,13 +38,72 @@ static inline void pic_outb(uint8_t port, unsigned int value)
 }
 
 
+/*
+ * Copy of the combined IMR (slave in the high byte). Masking a line then only
+ * writes the data port of the chip it belongs to, with no port read first
+ */
+extern uint16_t g_pic8259_mask;
+
+
+/*
+ * The master's half of the IMR. Slave lines only reach the CPU through the
+ * cascade input, so it is left open whenever any slave line is
+ */
+static inline uint8_t pic8259_master_imr(uint16_t mask)
+{
+    if(0xff != (mask >> 8))
+        return (mask & 0xff) & ~(1 << PIC8259_CASCADE_IRQ);
+
+    return mask & 0xff;
+}
+
+
+static inline void pic8259_setmask(irq_t mask)
+{
+    g_pic8259_mask = mask;
+    pic_outb(PIC8259_MASTER_DATA, pic8259_master_imr(mask));
+    pic_outb(PIC8259_SLAVE_DATA, (mask >> 8) & 0xff);
+}
+
+
+static inline uint16_t pic8259_getmask(void)
+{
+    return g_pic8259_mask;
+}
+
+
+static inline void pic8259_update_mask(irq_t irq, uint16_t mask)
+{
+    uint8_t old_master = pic8259_master_imr(g_pic8259_mask);
+
+    g_pic8259_mask = mask;
+
+    /* A slave line may also open or close the cascade input */
+    if( (irq < 8) || (old_master != pic8259_master_imr(mask)) )
+        pic_outb(PIC8259_MASTER_DATA, pic8259_master_imr(mask));
+    if(irq >= 8)
+        pic_outb(PIC8259_SLAVE_DATA, mask >> 8);
+}
+
+
+static inline void pic8259_mask_irq(irq_t irq)
+{
+    pic8259_update_mask(irq, g_pic8259_mask | (1 << irq));
+}
+
+
+static inline void pic8259_unmask_irq(irq_t irq)
+{
+    pic8259_update_mask(irq, g_pic8259_mask & ~(1 << irq));
+}
+
+
 void pic8259_init(void);
-void pic8259_mask_irq(irq_t irq);
-void pic8259_unmask_irq(irq_t irq);
-void pic8259_setmask(irq_t mask);
-uint16_t pic8259_getmask(void);
 void pic8259_flush(void);
-void pic8259_eoi(void);
+void pic8259_eoi(unsigned int vector);
+int pic8259_spurious(unsigned int vector);
+uint32_t pic8259_spurious_count(irq_t irq);
+void pic8259_stats_dump(void);
 
 uint16_t pic8259_get_irr(void);
 uint16_t pic8259_get_isr(void);
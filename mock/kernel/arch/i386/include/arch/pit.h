@@ -0,0 +1,31 @@
+#ifndef _ARCH_X86_PIT_H
+#define _ARCH_X86_PIT_H
+
+
+/*
+ * Intel 8253/8254 programmable interval timer. Channel 0 drives IRQ0;
+ * channel 2 is gated through port 0x61 and its output can be polled there,
+ * which makes it usable for calibration without interrupts
+ */
+#define PIT_HZ                  1193182u
+
+#define PIT_CH0                 0x40
+#define PIT_CH2                 0x42
+#define PIT_CMD                 0x43
+
+/* Mode/command register */
+#define PIT_SEL_CH0             (0 << 6)
+#define PIT_SEL_CH2             (2 << 6)
+#define PIT_ACCESS_LOHI         (3 << 4)
+#define PIT_MODE_ONESHOT        (0 << 1)    /* Interrupt on terminal count */
+#define PIT_MODE_RATE           (2 << 1)
+#define PIT_MODE_SQUARE         (3 << 1)
+
+/* Port 0x61: channel 2 gate and output, PC speaker */
+#define PIT_PORT_B              0x61
+#define PIT_PORT_B_GATE2        (1 << 0)
+#define PIT_PORT_B_SPEAKER      (1 << 1)
+#define PIT_PORT_B_OUT2         (1 << 5)
+
+
+#endif /* _ARCH_X86_PIT_H */
@@ -0,0 +1,447 @@
+#include <mock.h>
+#include <irq.h>
+#include <acpi/madt.h>
+#include <arch/irq.h>
+#include <arch/apic.h>
+#include <arch/pic8259.h>
+#include <arch/cpu.h>
+#include <arch/paging.h>
+#include <arch/irqflags.h>
+#include <kernel/init.h>
+
+/*
+ * Theory
+ *
+ * Each CPU has a local APIC, which accepts interrupts and delivers them to
+ * its core. External device lines end at one or more IOAPICs. Every IOAPIC
+ * input pin (a global system interrupt, GSI) has a redirection table entry
+ * that chooses the vector, trigger mode, polarity and destination APIC of
+ * the message sent when the pin fires.
+ *
+ * The ISA IRQs are normally wired to the IOAPIC pin of the same number. The
+ * firmware lists the exceptions in the MADT as interrupt source overrides;
+ * the PIT on IRQ0 usually arrives at GSI 2, for example. We route ISA IRQ n
+ * to vector IRQ_VECTOR_BASE + n, the same vector the remapped 8259 uses, so
+ * handlers do not care which controller is active.
+ *
+ * Acknowledging an interrupt is a single store to the local APIC EOI
+ * register. The 8259 needs one or two port writes, each of which is a slow
+ * bus cycle.
+ *
+ * A CPU that supports x2APIC is switched to it. Its registers are then MSRs
+ * rather than MMIO: the EOI is a wrmsr, and the interrupt command register
+ * becomes one 64-bit MSR. An IPI is therefore a single write, with no wait
+ * for the delivery status bit of the previous one. APIC IDs grow to 32 bits,
+ * but IOAPIC physical destinations remain 8 bits wide.
+ */
+
+#define MAX_IOAPICS     4
+#define MAX_CPUS        32
+
+struct ioapic {
+    uint32_t phys;
+    volatile uint32_t *base;
+    uint32_t gsi_base;
+    uint32_t nr_pins;
+    uint8_t id;
+};
+
+/* How an ISA IRQ reaches the IOAPIC */
+struct isa_route {
+    uint32_t gsi;
+    uint32_t rte_flags;         /* Polarity and trigger bits of the RTE */
+    int valid;                  /* Cleared when an override hands our GSI to another IRQ */
+};
+
+static volatile uint32_t *g_lapic = NULL;
+static uint32_t g_lapic_phys = 0;
+static int g_x2apic = 0;
+
+static struct ioapic g_ioapics[MAX_IOAPICS];
+static int g_nr_ioapics = 0;
+
+static struct isa_route g_isa_routes[ISA_NR_IRQS];
+
+/* Enabled processors from the MADT, and which of them are running */
+static uint32_t g_cpu_apic_ids[MAX_CPUS];
+static unsigned int g_nr_cpus = 0;
+static uint32_t g_cpu_online = 0;
+
+
+uint32_t lapic_read(uint32_t reg)
+{
+    if(g_x2apic)
+        return (uint32_t) rdmsr(X2APIC_MSR_BASE + reg / 16);
+
+    return g_lapic[reg / 4];
+}
+
+
+void lapic_write(uint32_t reg, uint32_t value)
+{
+    if(g_x2apic)
+        wrmsr(X2APIC_MSR_BASE + reg / 16, value);
+    else
+        g_lapic[reg / 4] = value;
+}
+
+
+uint32_t lapic_id(void)
+{
+    uint32_t id = lapic_read(LAPIC_ID);
+
+    return g_x2apic ? id : (id >> 24);
+}
+
+
+void lapic_send_ipi(uint32_t dest, uint32_t cmd)
+{
+    unsigned long flags = local_irq_save();
+
+    if(g_x2apic){
+        /* ICR is one MSR holding the destination in the high dword */
+        wrmsr(X2APIC_MSR_BASE + LAPIC_ICR_LOW / 16, ((uint64_t) dest << 32) | cmd);
+    }else{
+        while(lapic_read(LAPIC_ICR_LOW) & LAPIC_ICR_BUSY)
+            ;
+
+        /* Writing the low dword sends the IPI, so the destination goes first */
+        lapic_write(LAPIC_ICR_HIGH, dest << 24);
+        lapic_write(LAPIC_ICR_LOW, cmd);
+    }
+
+    local_irq_restore(flags);
+}
+
+
+static inline uint32_t ioapic_read(struct ioapic *io, uint32_t reg)
+{
+    io->base[IOAPIC_REGSEL / 4] = reg;
+    return io->base[IOAPIC_WINDOW / 4];
+}
+
+
+static inline void ioapic_write(struct ioapic *io, uint32_t reg, uint32_t value)
+{
+    io->base[IOAPIC_REGSEL / 4] = reg;
+    io->base[IOAPIC_WINDOW / 4] = value;
+}
+
+
+/*
+ * Find the IOAPIC serving a GSI, and the pin on it
+ */
+static struct ioapic *ioapic_for_gsi(uint32_t gsi, uint32_t *pin)
+{
+    for(int i = 0; i < g_nr_ioapics; i++){
+        struct ioapic *io = &g_ioapics[i];
+
+        if( (gsi >= io->gsi_base) && (gsi < io->gsi_base + io->nr_pins) ){
+            *pin = gsi - io->gsi_base;
+            return io;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void __init madt_parse(const struct acpi_madt_entry *entry, void *ctx)
+{
+    (void) ctx;
+
+    switch(entry->type){
+        case ACPI_MADT_LAPIC:
+        {
+            const struct acpi_madt_lapic *e = (const struct acpi_madt_lapic *) entry;
+
+            if( (e->flags & ACPI_MADT_LAPIC_ENABLED) && (g_nr_cpus < MAX_CPUS) )
+                g_cpu_apic_ids[g_nr_cpus++] = e->apic_id;
+        }
+            break;
+
+        case ACPI_MADT_IOAPIC:
+        {
+            const struct acpi_madt_ioapic *e = (const struct acpi_madt_ioapic *) entry;
+
+            if(g_nr_ioapics < MAX_IOAPICS){
+                g_ioapics[g_nr_ioapics++] = (struct ioapic) {
+                    .phys = e->addr, .base = NULL, .gsi_base = e->gsi_base, .nr_pins = 0, .id = e->id
+                };
+            }
+        }
+            break;
+
+        case ACPI_MADT_INT_OVERRIDE:
+        {
+            const struct acpi_madt_int_override *e = (const struct acpi_madt_int_override *) entry;
+            uint32_t rte_flags = 0;
+
+            if( (0 != e->bus) || (e->source >= ISA_NR_IRQS) )
+                break;
+
+            if(ACPI_MADT_POLARITY_LOW == (e->flags & ACPI_MADT_POLARITY_MASK))
+                rte_flags |= IOAPIC_RTE_POLARITY_LOW;
+            if(ACPI_MADT_TRIGGER_LEVEL == (e->flags & ACPI_MADT_TRIGGER_MASK))
+                rte_flags |= IOAPIC_RTE_TRIGGER_LEVEL;
+
+            g_isa_routes[e->source] = (struct isa_route) { .gsi = e->gsi, .rte_flags = rte_flags, .valid = 1 };
+
+            /*
+             * The GSI now belongs to e->source (IRQ0 -> GSI2 on most boards); an identity
+             * route for IRQ e->gsi would program the same pin with the wrong vector
+             */
+            if( (e->gsi < ISA_NR_IRQS) && (e->gsi != e->source) && (g_isa_routes[e->gsi].gsi == e->gsi) )
+                g_isa_routes[e->gsi].valid = 0;
+        }
+            break;
+
+        case ACPI_MADT_LAPIC_ADDR_OVERRIDE:
+        {
+            const struct acpi_madt_lapic_addr_override *e = (const struct acpi_madt_lapic_addr_override *) entry;
+
+            if(e->addr < 0x100000000ull)
+                g_lapic_phys = (uint32_t) e->addr;
+        }
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/* The boot CPU's APIC ID, read from CPUID since the LAPIC is not set up yet */
+static uint32_t __init boot_apic_id(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+
+    if( cpu_has(CPU_FEATURE_X2APIC) && (g_cpu_info.max_leaf >= 0xb) ){
+        cpuid_count(0xb, 0, &eax, &ebx, &ecx, &edx);
+        return edx;
+    }
+
+    cpuid(1, &eax, &ebx, &ecx, &edx);
+    return ebx >> 24;
+}
+
+
+kern_return_t __init apic_probe(void)
+{
+    struct acpi_madt *madt = (struct acpi_madt *) acpi_find_table("APIC");
+
+    if(NULL == madt)
+        return KERN_FAILURE;
+
+    /* ISA IRQs are identity mapped, edge triggered and active high unless overridden */
+    for(irq_t irq = 0; irq < ISA_NR_IRQS; irq++)
+        g_isa_routes[irq] = (struct isa_route) { .gsi = irq, .rte_flags = 0, .valid = 1 };
+
+    g_lapic_phys = madt->lapic_addr;
+    g_nr_cpus = 0;
+    acpi_madt_foreach(madt, madt_parse, NULL);
+
+    if( (0 == g_nr_ioapics) || (0 == g_lapic_phys) )
+        return KERN_FAILURE;
+
+    /* Without interrupt remapping the IOAPIC cannot address a CPU beyond APIC ID 0xff */
+    if(boot_apic_id() > 0xff){
+        printk("APIC: boot CPU APIC ID %u does not fit an IOAPIC destination\n", boot_apic_id());
+        return KERN_FAILURE;
+    }
+
+    return KERN_SUCCESS;
+}
+
+
+static void __init lapic_init(void)
+{
+    uint64_t base = rdmsr(MSR_IA32_APIC_BASE) | APIC_BASE_ENABLE;
+
+    /* xAPIC first; going straight from disabled to x2APIC is not allowed */
+    wrmsr(MSR_IA32_APIC_BASE, base);
+
+    if(cpu_has(CPU_FEATURE_X2APIC)){
+        wrmsr(MSR_IA32_APIC_BASE, base | APIC_BASE_X2APIC);
+        g_x2apic = 1;
+    }else{
+        g_lapic = (volatile uint32_t *) ioremap(g_lapic_phys, PAGE_SIZE);
+        assertk(NULL != g_lapic);
+    }
+
+    /* Accept every priority; leave the timer and LINT0 (ExtINT from the 8259) masked */
+    lapic_write(LAPIC_TPR, 0);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_LINT0, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_LVT_LINT1, LAPIC_LVT_DM_NMI);
+    lapic_write(LAPIC_LVT_ERROR, LAPIC_LVT_MASKED);
+
+    /* The ESR must be written before it is read; clear any stale errors */
+    lapic_write(LAPIC_ESR, 0);
+    lapic_write(LAPIC_ESR, 0);
+
+    plat.irq_insert(lapic_spurious_entry, LAPIC_SPURIOUS_VECTOR);
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+
+    /* Discard anything that was in service across the switch */
+    lapic_write(LAPIC_EOI, 0);
+}
+
+
+/* The IOAPIC and pin an ISA IRQ is routed to, or NULL if it has none */
+static struct ioapic *isa_route_lookup(irq_t irq, uint32_t *pin)
+{
+    if( (irq >= ISA_NR_IRQS) || !g_isa_routes[irq].valid )
+        return NULL;
+
+    return ioapic_for_gsi(g_isa_routes[irq].gsi, pin);
+}
+
+
+static void __init ioapic_init(uint32_t dest)
+{
+    /* apic_probe() refused any boot CPU the 8-bit destination field cannot hold */
+    assertk(dest <= 0xff);
+
+    for(int i = 0; i < g_nr_ioapics; i++){
+        struct ioapic *io = &g_ioapics[i];
+
+        io->base = (volatile uint32_t *) ioremap(io->phys, PAGE_SIZE);
+        assertk(NULL != io->base);
+
+        io->nr_pins = ((ioapic_read(io, IOAPIC_REG_VERSION) >> 16) & 0xff) + 1;
+        for(uint32_t pin = 0; pin < io->nr_pins; pin++)
+            ioapic_write(io, IOAPIC_REG_REDTBL(pin), IOAPIC_RTE_MASKED);
+    }
+
+    /* Fixed delivery, physical destination mode, to the boot CPU */
+    for(irq_t irq = 0; irq < ISA_NR_IRQS; irq++){
+        struct isa_route *route = &g_isa_routes[irq];
+        struct ioapic *io;
+        uint32_t pin;
+
+        io = isa_route_lookup(irq, &pin);
+        if(NULL == io)
+            continue;
+
+        ioapic_write(io, IOAPIC_REG_REDTBL(pin) + 1, dest << IOAPIC_RTE_DEST_SHIFT);
+        ioapic_write(io, IOAPIC_REG_REDTBL(pin), IOAPIC_RTE_MASKED | route->rte_flags | (IRQ_VECTOR_BASE + irq));
+    }
+}
+
+
+void __init apic_init(void)
+{
+    /* Park the 8259s where they cannot alias exceptions, and silence them */
+    pic8259_init();
+    pic8259_setmask(0xffff);
+
+    lapic_init();
+    ioapic_init(lapic_id());
+
+    /* We are running on the boot CPU; find its MADT index. ioapic_init() sent every line there */
+    for(unsigned int cpu = 0; cpu < g_nr_cpus; cpu++){
+        if(g_cpu_apic_ids[cpu] == lapic_id()){
+            apic_cpu_online(cpu);
+            irq_balance_init(cpu);
+        }
+    }
+
+    if(g_x2apic)
+        printk("APIC: local APIC %u in x2APIC mode, %d IOAPIC(s)\n", lapic_id(), g_nr_ioapics);
+    else
+        printk("APIC: local APIC %u at 0x%x, %d IOAPIC(s)\n", lapic_id(), g_lapic_phys, g_nr_ioapics);
+}
+
+
+int apic_enabled(void)
+{
+    return g_x2apic || (NULL != g_lapic);
+}
+
+
+void apic_eoi(unsigned int vector)
+{
+    /* Exceptions and software interrupts set no ISR bit */
+    if(vector < IRQ_VECTOR_BASE)
+        return;
+
+    lapic_write(LAPIC_EOI, 0);
+}
+
+
+static void ioapic_set_masked(irq_t irq, int masked)
+{
+    struct ioapic *io;
+    unsigned long flags;
+    uint32_t pin, rte;
+
+    io = isa_route_lookup(irq, &pin);
+    if(NULL == io)
+        return;
+
+    /* ioapic_set_target() runs from the balancer tasklet; keep the RMW and its index/window pairs whole */
+    flags = local_irq_save();
+    rte = ioapic_read(io, IOAPIC_REG_REDTBL(pin));
+    if(masked)
+        rte |= IOAPIC_RTE_MASKED;
+    else
+        rte &= ~IOAPIC_RTE_MASKED;
+    ioapic_write(io, IOAPIC_REG_REDTBL(pin), rte);
+    local_irq_restore(flags);
+}
+
+
+void ioapic_mask_irq(irq_t irq)
+{
+    ioapic_set_masked(irq, 1);
+}
+
+
+void ioapic_unmask_irq(irq_t irq)
+{
+    ioapic_set_masked(irq, 0);
+}
+
+
+void ioapic_setmask(irq_t mask)
+{
+    for(irq_t irq = 0; irq < ISA_NR_IRQS; irq++)
+        ioapic_set_masked(irq, mask & (1 << irq));
+}
+
+
+uint32_t apic_cpu_mask(void)
+{
+    return g_cpu_online;
+}
+
+
+void apic_cpu_online(unsigned int cpu)
+{
+    /* The IOAPIC destination field only holds an 8-bit APIC ID */
+    if( (cpu < g_nr_cpus) && (g_cpu_apic_ids[cpu] <= 0xff) )
+        g_cpu_online |= (1u << cpu);
+}
+
+
+kern_return_t ioapic_set_target(irq_t irq, unsigned int cpu)
+{
+    struct ioapic *io;
+    unsigned long flags;
+    uint32_t pin;
+
+    if( (cpu >= MAX_CPUS) || !(g_cpu_online & (1u << cpu)) )
+        return KERN_FAILURE;
+
+    io = isa_route_lookup(irq, &pin);
+    if(NULL == io)
+        return KERN_FAILURE;
+
+    /* The index/window pair must not be interleaved with a mask update */
+    flags = local_irq_save();
+    ioapic_write(io, IOAPIC_REG_REDTBL(pin) + 1, g_cpu_apic_ids[cpu] << IOAPIC_RTE_DEST_SHIFT);
+    local_irq_restore(flags);
+
+    return KERN_SUCCESS;
+}
@@ -3,6 +3,10 @@
 #include <arch/irq.h>
 #include <arch/pic8259.h>
 #include <arch/apic.h>
+#include <arch/cpu.h>
+#include <arch/irqflags.h>
+#include <kernel/init.h>
+#include <kernel/softirq.h>
 
 
 kern_return_t irq_insert_handler(irq_handler_t handler, irq_t slot)
@@ -38,7 +42,82 @@ irq_handler_t irq_get_handler(irq_t slot)
     struct gate_desc desc;
 
     idt_get_slot(slot, &desc);
-    return (irq_handler_t) ((desc.handler_addr1 << sizeof(irq_handler_t)/2) & (desc.handler_addr0));
+    return (irq_handler_t) (((uint32_t) desc.handler_addr1 << 16) | desc.handler_addr0);
+}
+
+
+static const char *g_exception_names[] = {
+    "Divide error", "Debug", "NMI", "Breakpoint", "Overflow", "BOUND range exceeded",
+    "Invalid opcode", "Device not available", "Double fault", "Coprocessor segment overrun",
+    "Invalid TSS", "Segment not present", "Stack-segment fault", "General protection fault",
+    "Page fault", "Reserved", "x87 floating point error", "Alignment check", "Machine check",
+    "SIMD floating point", "Virtualization"
+};
+
+
+/*
+ * An exception nobody claimed; returning would just fault again
+ */
+static void exception_fatal(struct irq_frame *frame)
+{
+    const char *name = (frame->vector <= EXC_VIRT) ? g_exception_names[frame->vector] : "Reserved";
+
+    printk("\n\n*** Unhandled exception [%u] %s, error 0x%x ***\n", frame->vector, name, frame->error_code);
+    printk("eip 0x%x cs 0x%x eflags 0x%x\n", frame->eip, frame->cs, frame->eflags);
+    printk("eax 0x%x ebx 0x%x ecx 0x%x edx 0x%x\n", frame->eax, frame->ebx, frame->ecx, frame->edx);
+    printk("esi 0x%x edi 0x%x ebp 0x%x esp 0x%x\n", frame->esi, frame->edi, frame->ebp, frame->esp);
+    if(EXC_PAGE_FAULT == frame->vector)
+        printk("cr2 0x%x\n", read_cr2());
+
+    while(1)
+        asm volatile("cli; hlt");
+}
+
+
+/* Whether the entry path can time handlers with the TSC */
+static int g_irq_use_tsc = 0;
+
+
+static inline int irq_spurious(unsigned int vector)
+{
+#ifdef IRQ_BACKEND_STATIC
+    return arch_irq_spurious(vector);
+#else
+    return (NULL != plat.irq_spurious) && plat.irq_spurious(vector);
+#endif
+}
+
+
+void irq_common_handler(struct irq_frame *frame)
+{
+    unsigned int vector = frame->vector;
+    uint64_t start;
+
+    /* A glitch on the controller; no handler to run and no regular EOI */
+    if(irq_spurious(vector))
+        return;
+
+    start = g_irq_use_tsc ? rdtsc() : 0;
+
+    if(!irq_dispatch(vector)){
+        if(vector < IRQ_VECTOR_BASE)
+            exception_fatal(frame);
+
+        printk("\n*** Unhandled interrupt [%u] ***\n", vector);
+    }
+
+    if(vector >= IRQ_VECTOR_BASE)
+        irq_eoi(vector);
+
+    irq_account(vector, g_irq_use_tsc ? (uint32_t) (rdtsc() - start) : 0);
+
+    /*
+     * Bottom halves, with interrupts enabled. Only after a device interrupt that
+     * came in with IF set: a claimed exception may have been raised inside a
+     * cli section or a handler that has not sent its EOI yet
+     */
+    if( (vector >= IRQ_VECTOR_BASE) && (frame->eflags & X86_EFLAGS_IF) )
+        irq_exit();
 }
 
 
@@ -54,28 +133,66 @@ static void arch_global_irq_disable(void)
 }
 
 
-static int irq_hw_detect(void)
+static int __init irq_hw_detect(void)
 {
-    //TODO: Do we have pic, apic, xapic, x2apic, etc
+#if defined(CONFIG_IRQ_BACKEND_PIC)
+    return IRQ_HW_PIC8259;
+#elif defined(CONFIG_IRQ_BACKEND_APIC)
+    return IRQ_HW_APIC;
+#endif
+
+    if(cpu_has(CPU_FEATURE_X2APIC))
+        return IRQ_HW_x2APIC;
+
+    if(cpu_has(CPU_FEATURE_APIC))
+        return IRQ_HW_APIC;
+
     return IRQ_HW_PIC8259;
 }
 
 
-void irq_init(void)
+void __init irq_init(void)
 {
     /* Set the functions that are not IRQ hardware-specific */
     plat.irq_global_disable =   arch_global_irq_disable;
     plat.irq_global_enable =    arch_global_irq_enable;
     plat.irq_insert =           irq_insert_handler;
+    g_irq_use_tsc =             cpu_has(CPU_FEATURE_TSC);
        
     /* Detect what hardware we have and set the utility functions */
     switch(irq_hw_detect()){
+        case IRQ_HW_x2APIC:
+        case IRQ_HW_xAPIC:
         case IRQ_HW_APIC:
+            if(KERN_SUCCESS == apic_probe()){
+                plat.irq_init =     apic_init;
+                plat.irq_disable =  ioapic_mask_irq;
+                plat.irq_enable =   ioapic_unmask_irq;
+                plat.irq_setmask =  ioapic_setmask;
+                plat.irq_eoi =      apic_eoi;
+                plat.irq_set_target = ioapic_set_target;
+                plat.irq_cpu_mask = apic_cpu_mask;
+                break;
+            }
+
+#ifdef CONFIG_IRQ_BACKEND_APIC
+            /* Every mask and EOI call was compiled for the APIC; there is no way back */
+            printk("APIC: no usable MADT in an APIC-only kernel!\n");
+            while(1)
+                asm volatile("cli; hlt");
+#else
+            /* No IOAPIC described by the firmware; the 8259 is still there */
+            printk("APIC: no usable MADT, falling back to the 8259\n");
+            __attribute__((fallthrough));
+#endif
         case IRQ_HW_PIC8259:
             plat.irq_init =     pic8259_init;
             plat.irq_disable =  pic8259_mask_irq;
             plat.irq_enable =   pic8259_unmask_irq;
             plat.irq_setmask =  pic8259_setmask;
+            plat.irq_eoi =      pic8259_eoi;
+            plat.irq_spurious = pic8259_spurious;
+            plat.irq_stats_dump = pic8259_stats_dump;
             break;
 
         default:
@@ -84,9 +201,13 @@ void irq_init(void)
 
     plat.irq_init();
     plat.irq_global_disable();
-    plat.irq_setmask(0xffff);
+    irq_setmask(0xffff);
+}
 
-    //FIXME: Remove this from this file
-    plat.irq_insert(time_systick_handler, 32);
-    plat.irq_insert(kb_handler_entry, 33);
+
+#ifndef IRQ_BACKEND_STATIC
+void irq_eoi(unsigned int vector)
+{
+    plat.irq_eoi(vector);
 }
+#endif
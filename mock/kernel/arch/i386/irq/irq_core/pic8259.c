@@ -1,6 +1,7 @@
 #include <arch/irq.h>
 #include <arch/pic8259.h>
 #include <mock.h>
+#include <kernel/init.h>
 
 /*
  * Theory
@@ -122,7 +123,7 @@ struct pic8259_conf {
 } g_pic8259_conf = {0};
 
 
-static void pic8259_remap(uint8_t moffset, uint8_t soffset)
+static void __init pic8259_remap(uint8_t moffset, uint8_t soffset)
 {
     /* ICW1: Edge triggered (default), cascade mode (deafult), ICW4 is needed */
     pic_outb(PIC8259_MASTER_CMD, ICW1_D4_BEGIN_ICW | ICW1_IC4_NEEDED);
@@ -140,11 +141,20 @@ static void pic8259_remap(uint8_t moffset, uint8_t soffset)
      *  Note: We inform the master that a slave device is connected to its IRQ2 line,
      *  while informing the slave that its identity is also two
      */
-    pic_outb(PIC8259_MASTER_DATA, (1 << 2));
+    pic_outb(PIC8259_MASTER_DATA, (1 << PIC8259_CASCADE_IRQ));
     pic_outb(PIC8259_SLAVE_DATA,        2);
 
-    /* ICW4: Non-buffered mode (default), EOI required (default), 8086 mode */ 
+    /* 
+     * ICW4: Non-buffered mode (default), 8086 mode. EOI is required by default;
+     * with CONFIG_PIC8259_AEOI the master clears its ISR bit itself at the end
+     * of the /INTA cycle, so timer and other master IRQs need no EOI at all.
+     * The slave always runs in normal EOI mode
+     */ 
+#ifdef CONFIG_PIC8259_AEOI
+    pic_outb(PIC8259_MASTER_DATA, ICW4_uPM_8086 | ICW4_AEOI);
+#else
     pic_outb(PIC8259_MASTER_DATA, ICW4_uPM_8086);
+#endif
     pic_outb(PIC8259_SLAVE_DATA,  ICW4_uPM_8086);
 
     /* Update our local configuration. Recall only b7-b3 are used when rebasing the 8259 */
@@ -162,73 +172,132 @@ static uint16_t pic8259_get_register(int reg)
 }
 
 
+uint16_t g_pic8259_mask = 0xffff;
+
+
 void pic8259_disable(void)
 {
     pic8259_setmask(0xffff);
 }
 
 
-uint16_t pic8259_getmask(void)
+uint16_t pic8259_get_irr(void)
 {
-    return (pic_inb(PIC8259_SLAVE_DATA) << 8) | pic_inb(PIC8259_MASTER_DATA);
+    return pic8259_get_register(OCW3_INT_REQUEST_REG);
 }
 
 
-void pic8259_mask_irq(irq_t irq)
+uint16_t pic8259_get_isr(void)
 {
-    pic8259_setmask(pic8259_getmask() | (1 << irq));
+    return pic8259_get_register(OCW3_IN_SERVICE_REG);
 }
 
 
-void pic8259_unmask_irq(irq_t irq)
+/*
+ * The vector alone tells us which chip raised the interrupt, so there is no
+ * need to read the ISR back first. That costs a port write and a port read
+ * per chip
+ */
+void pic8259_eoi(unsigned int vector)
 {
-    pic8259_setmask(pic8259_getmask() & ~(1 << irq));    
-}
+    unsigned int irq = vector - g_pic8259_conf.master_voffset;
 
+    /* Exceptions and software interrupts never went through the 8259 */
+    if(irq >= 16)
+        return;
 
-void pic8259_setmask(irq_t mask)
-{
-    pic_outb(PIC8259_MASTER_DATA, mask & 0xff);
-    pic_outb(PIC8259_SLAVE_DATA, mask >> 8);
+    /* Send the slave an EOI if it was the source of the interrupt */
+    if(irq >= 8)
+        pic_outb(PIC8259_SLAVE_CMD, OCW2_NON_SPECIFIC_EOI);
+
+#ifndef CONFIG_PIC8259_AEOI
+    /*
+     * Either the master was the source of the interrupt or it was
+     * a proxy for the slave. Either way we need to send an EOI
+     */
+    pic_outb(PIC8259_MASTER_CMD, OCW2_NON_SPECIFIC_EOI);
+#endif
 }
 
 
-uint16_t pic8259_get_irr(void)
+/* Spurious interrupts seen on IRQ7 and IRQ15 */
+static uint32_t g_pic8259_spurious[2] = {0};
+
+
+static uint8_t pic8259_read_isr(unsigned int cmd_port)
 {
-    return pic8259_get_register(OCW3_INT_REQUEST_REG);
+    pic_outb(cmd_port, PIC8259_REG_ISR);
+    return pic_inb(cmd_port);
 }
 
 
-uint16_t pic8259_get_isr(void)
+/*
+ * When a request goes away before the /INTA cycle, the 8259 still hands out
+ * its lowest-priority vector (IRQ7, or IRQ15 on the slave) with no ISR bit
+ * set. Such an interrupt must not be handled and must not be EOI'd on the
+ * chip that raised it, or the EOI would retire some other in-service IRQ. A
+ * spurious IRQ15 did, however, come through the master's cascade input,
+ * so the master still wants its EOI
+ *
+ * @param vector : The vector that was delivered
+ * @return       : 1 if the interrupt was spurious and has been dealt with
+ */
+int pic8259_spurious(unsigned int vector)
 {
-    return pic8259_get_register(OCW3_IN_SERVICE_REG);
+    unsigned int irq = vector - g_pic8259_conf.master_voffset;
+
+    if(7 == irq){
+#ifdef CONFIG_PIC8259_AEOI
+        /* The master already cleared its ISR bit itself; there is nothing to check */
+        return 0;
+#else
+        if(pic8259_read_isr(PIC8259_MASTER_CMD) & (1 << 7))
+            return 0;
+
+        g_pic8259_spurious[0]++;
+        return 1;
+#endif
+    }
+
+    if(15 == irq){
+        if(pic8259_read_isr(PIC8259_SLAVE_CMD) & (1 << 7))
+            return 0;
+
+        g_pic8259_spurious[1]++;
+#ifndef CONFIG_PIC8259_AEOI
+        pic_outb(PIC8259_MASTER_CMD, OCW2_NON_SPECIFIC_EOI);
+#endif
+        return 1;
+    }
+
+    return 0;
 }
 
 
-void pic8259_eoi(void)
+uint32_t pic8259_spurious_count(irq_t irq)
 {
-    uint16_t isr,irr;
-    
-    isr = pic8259_get_isr();
-    irr = pic8259_get_irr();
-    (void)irr;
+    if(7 == irq)
+        return g_pic8259_spurious[0];
 
-    /* Send the slave an EOI if it was the source of the interrupt */
-    if(isr & 0xff00){
-        pic_outb(PIC8259_SLAVE_CMD, OCW2_NON_SPECIFIC_EOI);
-    }
+    if(15 == irq)
+        return g_pic8259_spurious[1];
 
-    /*
-     * Either the master was the source of the interrupt or it was
-     * a proxy for the slave. Either way we need to send an EOI
-     */
-    pic_outb(PIC8259_MASTER_CMD, OCW2_NON_SPECIFIC_EOI);
+    return 0;
 }
 
 
-void pic8259_init(void)
+void pic8259_stats_dump(void)
+{
+    printk("8259 spurious: IRQ7 %u, IRQ15 %u\n", pic8259_spurious_count(7), pic8259_spurious_count(15));
+}
+
+
+void __init pic8259_init(void)
 {
     pic8259_disable();
     pic8259_remap(PIC8259_MASTER_REMAP_BASE, PIC8259_SLAVE_REMAP_BASE);
+
+    /* ICW1 cleared the IMR; bring the chips back in line with g_pic8259_mask */
+    pic8259_disable();
 }
 
@@ -1,11 +1,184 @@
+#include <stddef.h>
 #include <kernel/printk.h>
+#include <kernel/init.h>
+#include <kernel/softirq.h>
+#include <kernel/ring.h>
+#include <irq.h>
 #include <arch/io.h>
+#include <arch/irq.h>
+#include <arch/irq/keyboard.h>
 
 
-void kb_handler(void){ 
+#define KB_PORT_DATA        0x60
+#define KB_PORT_STATUS      0x64
+#define KB_STATUS_OBF       (1 << 0)
+
+#define SC_EXTENDED         0xE0
+#define SC_BREAK            0x80
+
+#define SC_LSHIFT           0x2A
+#define SC_RSHIFT           0x36
+#define SC_CTRL             0x1D
+#define SC_ALT              0x38
+#define SC_CAPSLOCK         0x3A
+
+/*
+ * The interrupt handler is the only producer of scancodes and the tasklet the
+ * only consumer; the tasklet is in turn the only producer of events and
+ * keyboard_read_event() their only consumer
+ */
+static RING(uint8_t, 64) g_kb_scancodes;
+static RING(struct kb_event, 32) g_kb_events;
+
+/* Input lost because a ring was full */
+static uint32_t g_kb_dropped_scancodes = 0;
+static uint32_t g_kb_dropped_events = 0;
+
+/* Decoder state; only touched by the tasklet */
+static uint8_t g_kb_modifiers = 0;
+static int g_kb_extended = 0;
+
+
+/* Scancode set 1 make codes to US layout characters */
+static const char g_kb_map[] = {
+    0,    0x1b, '1',  '2',  '3',  '4',  '5',  '6',  '7',  '8',  '9',  '0',  '-',  '=',  '\b', '\t',
+    'q',  'w',  'e',  'r',  't',  'y',  'u',  'i',  'o',  'p',  '[',  ']',  '\n', 0,    'a',  's',
+    'd',  'f',  'g',  'h',  'j',  'k',  'l',  ';',  '\'', '`',  0,    '\\', 'z',  'x',  'c',  'v',
+    'b',  'n',  'm',  ',',  '.',  '/',  0,    '*',  0,    ' '
+};
+
+static const char g_kb_map_shift[] = {
+    0,    0x1b, '!',  '@',  '#',  '$',  '%',  '^',  '&',  '*',  '(',  ')',  '_',  '+',  '\b', '\t',
+    'Q',  'W',  'E',  'R',  'T',  'Y',  'U',  'I',  'O',  'P',  '{',  '}',  '\n', 0,    'A',  'S',
+    'D',  'F',  'G',  'H',  'J',  'K',  'L',  ':',  '"',  '~',  0,    '|',  'Z',  'X',  'C',  'V',
+    'B',  'N',  'M',  '<',  '>',  '?',  0,    '*',  0,    ' '
+};
+
+
+static char kb_translate(uint8_t code, uint8_t mods)
+{
+    int shift = !!(mods & KB_MOD_SHIFT);
+    char c;
+
+    if(code >= sizeof(g_kb_map))
+        return 0;
+
+    c = g_kb_map[code];
+
+    /* Caps lock only inverts the shift state of letters */
+    if( (mods & KB_MOD_CAPSLOCK) && (c >= 'a') && (c <= 'z') )
+        shift = !shift;
+
+    return shift ? g_kb_map_shift[code] : c;
+}
+
+
+static void kb_update_modifiers(uint8_t code, int pressed)
+{
+    uint8_t bit;
+
+    switch(code){
+        case SC_LSHIFT:
+        case SC_RSHIFT:     bit = KB_MOD_SHIFT; break;
+        case SC_CTRL:       bit = KB_MOD_CTRL;  break;
+        case SC_ALT:        bit = KB_MOD_ALT;   break;
+        case SC_CAPSLOCK:
+            if(pressed)
+                g_kb_modifiers ^= KB_MOD_CAPSLOCK;
+            return;
+        default:
+            return;
+    }
+
+    if(pressed)
+        g_kb_modifiers |= bit;
+    else
+        g_kb_modifiers &= ~bit;
+}
+
+
+/*
+ * Turn one scancode into at most one event
+ */
+static void kb_decode(uint8_t sc)
+{
+    struct kb_event ev;
+    uint8_t code = sc & ~SC_BREAK;
+
+    if(SC_EXTENDED == sc){
+        g_kb_extended = 1;
+        return;
+    }
+
+    ev.pressed = !(sc & SC_BREAK);
+    ev.keycode = code;
+
+    /* Right ctrl/alt arrive as extended versions of the left ones */
+    kb_update_modifiers(code, ev.pressed);
+
+    if(g_kb_extended){
+        ev.keycode |= KB_KEY_EXTENDED;
+        ev.ascii = 0;
+        g_kb_extended = 0;
+    }else{
+        ev.ascii = kb_translate(code, g_kb_modifiers);
+    }
+
+    ev.modifiers = g_kb_modifiers;
+
+    if(!ring_put(&g_kb_events, ev))
+        g_kb_dropped_events++;
+}
+
+
+/*
+ * Bottom half: decode everything the interrupt handler queued
+ */
+static void kb_tasklet_fn(void *ctx)
+{
+    uint8_t sc;
+    (void) ctx;
+
+    while(ring_get(&g_kb_scancodes, &sc))
+        kb_decode(sc);
+}
+
+static struct tasklet g_kb_tasklet = TASKLET_INIT(kb_tasklet_fn, NULL);
+
+
+/*
+ * Top half: drain the controller and defer the rest
+ */
+static enum irq_return kb_handler(irq_t irq, void *ctx)
+{ 
     int num = 0; 
+    (void) irq;
+    (void) ctx;
     
-    while(inb(0x64) & 1){ 
-        printk("KB: 0x%x [%d]\n", inb(0x60), num++); 
+    while(inb(KB_PORT_STATUS) & KB_STATUS_OBF){ 
+        uint8_t sc = inb(KB_PORT_DATA);
+
+        if(!ring_put(&g_kb_scancodes, sc))
+            g_kb_dropped_scancodes++;
+        num++;
     } 
-}   
+
+    if(0 == num)
+        return IRQ_NONE;
+
+    tasklet_schedule(&g_kb_tasklet);
+    return IRQ_HANDLED;
+}
+
+
+int keyboard_read_event(struct kb_event *ev)
+{
+    return ring_get(&g_kb_events, ev);
+}
+
+
+void __init keyboard_init(void)
+{
+    if(KERN_SUCCESS != request_irq(1, kb_handler, NULL))
+        printk("Failed to register the keyboard handler!\n");
+}
@@ -0,0 +1,69 @@
+#include <mock.h>
+#include <irq.h>
+#include <kernel/init.h>
+#include <kernel/clockevent.h>
+#include <kernel/clocksource.h>
+#include <kernel/hrtimer.h>
+#include <kernel/math64.h>
+#include <arch/apic.h>
+#include <arch/cpu.h>
+#include <arch/irq/time.h>
+
+/*
+ * The local APIC timer in TSC-deadline mode. The deadline is written as an
+ * absolute TSC value to IA32_TSC_DEADLINE, and the timer fires once the TSC
+ * passes it. There is no divider or counter to calibrate beyond the TSC
+ * itself, and the range covers the whole 64-bit TSC. Each arming is a
+ * single wrmsr. It serves as the hrtimer device.
+ */
+
+#define MSR_IA32_TSC_DEADLINE       0x6E0
+
+/* Nanoseconds to TSC cycles */
+static uint32_t g_tsc_deadline_mult, g_tsc_deadline_shift;
+
+
+static void tsc_deadline_set_next_event(uint64_t delta_ns, struct clock_event_device *dev)
+{
+    (void) dev;
+    wrmsr(MSR_IA32_TSC_DEADLINE, rdtsc() + mul_u64_u32_shr(delta_ns, g_tsc_deadline_mult, g_tsc_deadline_shift));
+}
+
+static struct clock_event_device g_tsc_deadline_clockevent = {
+    .name           = "lapic-tsc-deadline",
+    .features       = CLOCK_EVT_FEAT_ONESHOT,
+    .min_delta_ns   = 1000,
+    .max_delta_ns   = 3600 * NSEC_PER_SEC,
+    .rating         = 300,
+    .set_next_event = tsc_deadline_set_next_event,
+};
+
+
+static enum irq_return lapic_timer_handler(irq_t irq, void *ctx)
+{
+    (void) irq;
+    (void) ctx;
+
+    g_tsc_deadline_clockevent.event_handler(&g_tsc_deadline_clockevent);
+    return IRQ_HANDLED;
+}
+
+
+void __init lapic_timer_init(void)
+{
+    uint64_t tsc_hz = tsc_get_hz();
+
+    if( !apic_enabled() || !cpu_has(CPU_FEATURE_TSC_DEADLINE) || (0 == tsc_hz) )
+        return;
+
+    if(KERN_SUCCESS != request_vector(LAPIC_TIMER_VECTOR, lapic_timer_handler, NULL))
+        return;
+
+    clocks_calc_mult_shift(&g_tsc_deadline_mult, &g_tsc_deadline_shift, NSEC_PER_SEC, tsc_hz);
+
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_LVT_TIMER_TSC_DEADLINE | LAPIC_TIMER_VECTOR);
+
+    /* The LVT store (MMIO in xAPIC mode) must land before the first deadline wrmsr */
+    asm volatile("mfence" : : : "memory");
+    hrtimer_register_device(&g_tsc_deadline_clockevent);
+}
@@ -1,23 +1,131 @@
 #include <mock.h>
+#include <irq.h>
+#include <kernel/init.h>
+#include <kernel/clocksource.h>
+#include <kernel/clockevent.h>
+#include <kernel/jiffies.h>
+#include <kernel/math64.h>
+#include <arch/irq.h>
+#include <arch/io.h>
+#include <arch/pit.h>
 
+/*
+ * PIT channel 0 is the tick device. In periodic mode it reloads itself with
+ * PIT_LATCH every time it reaches zero. In one-shot mode it counts down once
+ * from whatever set_next_event() loaded and then stays quiet. The 16-bit
+ * counter limits one shot to about 55ms.
+ */
 
-volatile uint32_t g_systick = 0;
+#define PIT_LATCH       ((PIT_HZ + HZ / 2) / HZ)
+#define PIT_MAX_COUNT   0xffff
+#define PIT_MIN_COUNT   2
+
+/* pit_load() takes 16 bits; a HZ too low or too high would wrap or stall the tick */
+_Static_assert((PIT_LATCH <= PIT_MAX_COUNT) && (PIT_LATCH >= PIT_MIN_COUNT), "HZ is out of range for the PIT");
+
+/* Nanoseconds to PIT counts */
+static uint32_t g_pit_mult, g_pit_shift;
+
+
+static void pit_load(uint8_t mode, uint16_t count)
+{
+    outb(PIT_CMD, PIT_SEL_CH0 | PIT_ACCESS_LOHI | mode);
+    outb(PIT_CH0, count & 0xff);
+    outb(PIT_CH0, count >> 8);
+}
+
+
+static void pit_set_periodic(struct clock_event_device *dev)
+{
+    (void) dev;
+    pit_load(PIT_MODE_RATE, PIT_LATCH);
+}
+
+
+static void pit_set_next_event(uint64_t delta_ns, struct clock_event_device *dev)
+{
+    uint64_t count = mul_u64_u32_shr(delta_ns, g_pit_mult, g_pit_shift);
+    (void) dev;
+
+    if(count < PIT_MIN_COUNT)
+        count = PIT_MIN_COUNT;
+    if(count > PIT_MAX_COUNT)
+        count = PIT_MAX_COUNT;
+
+    pit_load(PIT_MODE_ONESHOT, count);
+}
+
+static struct clock_event_device g_pit_clockevent = {
+    .name           = "pit",
+    .features       = CLOCK_EVT_FEAT_PERIODIC | CLOCK_EVT_FEAT_ONESHOT,
+    .min_delta_ns   = PIT_MIN_COUNT * NSEC_PER_SEC / PIT_HZ + 1,
+    .max_delta_ns   = PIT_MAX_COUNT * NSEC_PER_SEC / PIT_HZ,
+    .rating         = 100,
+    .set_periodic   = pit_set_periodic,
+    .set_next_event = pit_set_next_event,
+};
+
+
+static enum irq_return pit_handler(irq_t irq, void *ctx)
+{
+    (void) irq;
+    (void) ctx;
+
+    if(NULL != g_pit_clockevent.event_handler)
+        g_pit_clockevent.event_handler(&g_pit_clockevent);
+
+    return IRQ_HANDLED;
+}
+
+
+/*
+ * The jiffies count, as a last resort clocksource with tick resolution.
+ * One jiffy is PIT_LATCH PIT counts, which is not exactly TICK_NSEC
+ */
+static uint64_t jiffies_read(void)
+{
+    return get_jiffies_64();
+}
+
+static struct clocksource g_jiffies_clocksource = {
+    .name   = "jiffies",
+    .read   = jiffies_read,
+    .mask   = ~0ull,
+    .mult   = (uint32_t) (PIT_LATCH * NSEC_PER_SEC / PIT_HZ),
+    .shift  = 0,
+    .rating = CLOCKSOURCE_RATING_TICK,
+};
+
+
+void __init time_init(void)
+{
+    clocks_calc_mult_shift(&g_pit_mult, &g_pit_shift, NSEC_PER_SEC, PIT_HZ);
+    clockevents_register_device(&g_pit_clockevent);
+    tick_init();
+
+    if(KERN_SUCCESS != request_irq(0, pit_handler, NULL))
+        printk("Failed to register the PIT handler!\n");
+
+    clocksource_register(&g_jiffies_clocksource);
+    tsc_init();
+    lapic_timer_init();
+
+    /* Only once a clocksource that does not need the tick is in place */
+    tick_nohz_enable();
+}
 
 
 uint32_t time_get_systick(void)
 {
-    return  g_systick;
+    return g_jiffies;
 }
 
+
 void time_delay_msec(uint32_t msec)
 {
-    uint32_t ctime = g_systick;
-    int ticks = msec/54.5;
+    uint64_t start = ktime_get_ns();
 
-    //FIXME: take into account the current tick resolution
-    while(g_systick < (ctime + ticks))
+    /* Differences of a monotonic 64-bit count; no rollover to worry about */
+    while(ktime_get_ns() - start < msec * NSEC_PER_MSEC)
         ;
-
-    //FIXME: rollover
 }
-    
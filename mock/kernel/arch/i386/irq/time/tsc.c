@@ -0,0 +1,120 @@
+#include <mock.h>
+#include <kernel/clocksource.h>
+#include <kernel/init.h>
+#include <arch/cpu.h>
+#include <arch/io.h>
+#include <arch/pit.h>
+#include <arch/irq/time.h>
+
+/*
+ * The TSC counts CPU cycles at a rate we are not told, so it is measured
+ * against PIT channel 2. That channel is gated by software and its output can
+ * be polled, so no interrupts are involved. One run counts TSC cycles
+ * across TSC_CALIBRATE_MS of PIT time. SMIs or a slow port access can only
+ * make a run look longer, so the shortest of several runs is kept.
+ */
+
+#define TSC_CALIBRATE_MS        10
+#define TSC_CALIBRATE_RUNS      5
+
+/*
+ * Polls of port B before giving up on OUT2. Each is an I/O access of roughly a
+ * microsecond, so this is far beyond TSC_CALIBRATE_MS on any real machine
+ */
+#define TSC_CALIBRATE_POLLS     1000000
+
+static uint64_t g_tsc_hz = 0;
+
+
+static uint64_t tsc_read(void)
+{
+    return rdtsc();
+}
+
+static struct clocksource g_tsc_clocksource = {
+    .name   = "tsc",
+    .read   = tsc_read,
+    .mask   = ~0ull,
+    .rating = 300,
+};
+
+
+/*
+ * @return  : TSC cycles across one calibration period, or 0 if OUT2 never rose
+ */
+static uint64_t __init tsc_calibrate_once(void)
+{
+    uint32_t latch = PIT_HZ * TSC_CALIBRATE_MS / 1000;
+    uint32_t polls = 0;
+    uint64_t start, end;
+    uint8_t portb;
+
+    /* Gate channel 2 off, keep the speaker quiet */
+    portb = inb(PIT_PORT_B) & ~(PIT_PORT_B_GATE2 | PIT_PORT_B_SPEAKER);
+    outb(PIT_PORT_B, portb);
+
+    /* Terminal count mode: OUT2 goes high once 'latch' ticks have elapsed */
+    outb(PIT_CMD, PIT_SEL_CH2 | PIT_ACCESS_LOHI | PIT_MODE_ONESHOT);
+    outb(PIT_CH2, latch & 0xff);
+    outb(PIT_CH2, latch >> 8);
+
+    /* Raising the gate starts the count */
+    outb(PIT_PORT_B, portb | PIT_PORT_B_GATE2);
+    start = rdtsc();
+
+    /* Some hypervisors do not wire OUT2 to port B at all */
+    while(0 == (inb(PIT_PORT_B) & PIT_PORT_B_OUT2)){
+        if(++polls == TSC_CALIBRATE_POLLS){
+            outb(PIT_PORT_B, portb);
+            return 0;
+        }
+    }
+
+    end = rdtsc();
+    outb(PIT_PORT_B, portb);
+
+    return end - start;
+}
+
+
+void __init tsc_init(void)
+{
+    uint64_t best = ~0ull;
+
+    if(!cpu_has(CPU_FEATURE_TSC))
+        return;
+
+    for(int i = 0; i < TSC_CALIBRATE_RUNS; i++){
+        uint64_t cycles = tsc_calibrate_once();
+
+        /* Without a reference there is no rate; the jiffies clocksource stays */
+        if(0 == cycles){
+            printk("TSC: PIT channel 2 output never rose, not using the TSC\n");
+            return;
+        }
+
+        if(cycles < best)
+            best = cycles;
+    }
+
+    g_tsc_hz = best * (1000 / TSC_CALIBRATE_MS);
+    if(0 == g_tsc_hz)
+        return;
+
+    /* A TSC that changes rate with P-states is only good for the fallback's rating */
+    if(!cpu_has(CPU_FEATURE_INVARIANT_TSC)){
+        printk("TSC: not invariant, timekeeping may drift with frequency changes\n");
+        g_tsc_clocksource.rating = 150;
+    }
+
+    printk("TSC: %u.%03u MHz\n", (uint32_t) (g_tsc_hz / 1000000), (uint32_t) (g_tsc_hz / 1000 % 1000));
+
+    clocksource_set_hz(&g_tsc_clocksource, g_tsc_hz);
+    clocksource_register(&g_tsc_clocksource);
+}
+
+
+uint64_t tsc_get_hz(void)
+{
+    return g_tsc_hz;
+}
@@ -0,0 +1,203 @@
+#include <mock.h>
+#include <multiboot/multiboot.h>
+#include <kernel/page_alloc.h>
+#include <arch/page.h>
+#include <arch/mm.h>
+#include <arch/paging.h>
+#include <kernel/init.h>
+
+
+/* We only manage memory the kernel can reach through the direct map */
+#define PHYS_LIMIT          ((uint64_t) DIRECT_MAP_SIZE)
+
+/* The real-mode IVT, BDA, EBDA, VGA memory and BIOS ROM all live below 1 MiB */
+#define LOW_MEMORY_END      0x100000
+
+#define MAX_RESERVED        32
+
+
+struct mem_range {
+    uint64_t start;
+    uint64_t end;
+};
+
+static struct mem_range g_reserved[MAX_RESERVED] __initdata;
+static int g_nr_reserved __initdata = 0;
+
+
+static void __init reserve_range(uint64_t start, uint64_t end)
+{
+    assertk(g_nr_reserved < MAX_RESERVED);
+
+    g_reserved[g_nr_reserved++] = (struct mem_range) {
+        .start = start & PAGE_MASK,
+        .end = (end + PAGE_SIZE - 1) & ~(uint64_t) (PAGE_SIZE - 1)
+    };
+}
+
+
+/* Clip a memory map entry to usable, page-aligned RAM below PHYS_LIMIT */
+static int __init usable_range(uint64_t base, uint64_t len, uint32_t type, struct mem_range *out)
+{
+    uint64_t end = base + len;
+
+    if( (MULTIBOOT_MEMORY_AVAILABLE != type) || (base >= PHYS_LIMIT) )
+        return 0;
+
+    if(end > PHYS_LIMIT)
+        end = PHYS_LIMIT;
+
+    out->start = (base + PAGE_SIZE - 1) & ~(uint64_t) (PAGE_SIZE - 1);
+    out->end = end & ~(uint64_t) (PAGE_SIZE - 1);
+
+    return out->start < out->end;
+}
+
+
+static void __init find_max_pfn(uint64_t base, uint64_t len, uint32_t type, void *ctx)
+{
+    uint32_t *max_pfn = (uint32_t *) ctx;
+    struct mem_range r;
+
+    if(usable_range(base, len, type, &r) && (r.end >> PAGE_SHIFT) > *max_pfn)
+        *max_pfn = r.end >> PAGE_SHIFT;
+}
+
+
+struct map_fit {
+    uint64_t start;
+    uint64_t size;
+    int found;
+};
+
+static void __init check_fit(uint64_t base, uint64_t len, uint32_t type, void *ctx)
+{
+    struct map_fit *fit = (struct map_fit *) ctx;
+    struct mem_range r;
+
+    if(usable_range(base, len, type, &r) && (fit->start >= r.start) && (fit->start + fit->size <= r.end))
+        fit->found = 1;
+}
+
+
+/*
+ * Hand a RAM region to the page allocator, minus every reserved range
+ */
+static void __init release_range(uint64_t base, uint64_t len, uint32_t type, void *ctx)
+{
+    struct mem_range r;
+    uint64_t cur;
+    (void) ctx;
+
+    if(!usable_range(base, len, type, &r))
+        return;
+
+    cur = r.start;
+    while(cur < r.end){
+        uint64_t next = r.end;
+        int skipped = 0;
+
+        for(int i = 0; i < g_nr_reserved; i++){
+            if( (g_reserved[i].start <= cur) && (cur < g_reserved[i].end) ){
+                cur = g_reserved[i].end;
+                skipped = 1;
+                break;
+            }
+
+            if( (g_reserved[i].start > cur) && (g_reserved[i].start < next) )
+                next = g_reserved[i].start;
+        }
+
+        if(skipped)
+            continue;
+
+        page_alloc_free_range((phys_addr_t) cur, next);
+        cur = next;
+    }
+}
+
+
+/*
+ * Fallback for bootloaders without a memory map: mem_upper is the amount of
+ * contiguous RAM (in KiB) starting at 1 MiB
+ */
+static void __init mb_basic_foreach(struct multiboot_info *mbi, mb_mmap_fn_t fn, void *ctx)
+{
+    if(mbi->flags & MULTIBOOT_INFO_MEM_MAP)
+        mb_mmap_foreach(mbi, fn, ctx);
+    else if(mbi->flags & MULTIBOOT_INFO_MEMORY)
+        fn(LOW_MEMORY_END, (uint64_t) mbi->mem_upper * 1024, MULTIBOOT_MEMORY_AVAILABLE, ctx);
+}
+
+
+void __init x86_memory_init(struct multiboot_info *mbi)
+{
+    uint32_t max_pfn = 0;
+    uint64_t map_start = PAGE_ALIGN(__pa(__stacktop));
+    uint64_t map_size;
+    struct map_fit fit;
+
+    mb_basic_foreach(mbi, find_max_pfn, &max_pfn);
+    if(0 == max_pfn){
+        printk("No usable memory reported by the bootloader!\n");
+        abort();
+    }
+
+    /* Firmware areas, the kernel image and everything the bootloader handed us */
+    reserve_range(0, LOW_MEMORY_END);
+    reserve_range(__pa(__kernel_start), __pa(__stacktop));
+    reserve_range(__pa(mbi), __pa(mbi) + sizeof(*mbi));
+
+    if(mbi->flags & MULTIBOOT_INFO_CMDLINE)
+        reserve_range(mbi->cmdline, mbi->cmdline + PAGE_SIZE);
+
+    if(mbi->flags & MULTIBOOT_INFO_MEM_MAP)
+        reserve_range(mbi->mmap_addr, mbi->mmap_addr + mbi->mmap_length);
+
+    if(mbi->flags & MULTIBOOT_INFO_MODS){
+        multiboot_module_t *mod = (multiboot_module_t *) __va(mbi->mods_addr);
+
+        reserve_range(mbi->mods_addr, mbi->mods_addr + mbi->mods_count * sizeof(*mod));
+        for(uint32_t i = 0; i < mbi->mods_count; i++){
+            reserve_range(mod[i].mod_start, mod[i].mod_end);
+
+            /* Modules usually follow the kernel; keep the frame array clear of them */
+            if(mod[i].mod_end > map_start)
+                map_start = PAGE_ALIGN(mod[i].mod_end);
+        }
+    }
+
+    /*
+     * The frame array, followed by any page tables the direct map needs, goes
+     * in the first RAM past the kernel and modules. Both have to be reachable
+     * through the boot mapping, since they are written before paging_init()
+     */
+    map_size = PAGE_ALIGN(page_alloc_map_size(max_pfn));
+    fit = (struct map_fit) { .start = map_start, .size = map_size + paging_early_size(max_pfn), .found = 0 };
+    mb_basic_foreach(mbi, check_fit, &fit);
+    if( !fit.found || (fit.start + fit.size > BOOT_MAP_SIZE) ){
+        printk("No room for the page frame array (%u bytes)!\n", (uint32_t) fit.size);
+        abort();
+    }
+    reserve_range(fit.start, fit.start + fit.size);
+
+    page_alloc_init((struct page *) __va(fit.start), max_pfn);
+    paging_init((phys_addr_t) (fit.start + map_size));
+    mb_basic_foreach(mbi, release_range, NULL);
+
+    printk("Memory: %u KiB available, max_pfn=0x%x, frame array at 0x%x\n",
+            page_alloc_nr_free() * (PAGE_SIZE / 1024), max_pfn, (uint32_t) fit.start);
+}
+
+
+void free_initmem(void)
+{
+    phys_addr_t start = __pa(__init_start);
+    phys_addr_t end = __pa(__init_end);
+
+    /* Poison with int3 so a stray call into freed boot code traps at once */
+    memset(__init_start, 0xCC, __init_end - __init_start);
+    page_alloc_free_range(start, end);
+
+    printk("Freeing unused kernel memory: %u KiB\n", (end - start) / 1024);
+}
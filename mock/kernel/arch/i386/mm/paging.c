@@ -0,0 +1,247 @@
+#include <mock.h>
+#include <kernel/page_alloc.h>
+#include <arch/cpu.h>
+#include <arch/page.h>
+#include <arch/paging.h>
+#include <arch/irqflags.h>
+#include <kernel/init.h>
+
+/*
+ * Kernel page tables.
+ *
+ * Physical RAM is mapped linearly at __va() with one 4 MiB PSE page per
+ * directory entry. The kernel image lives inside that mapping, so its text,
+ * data and the direct map together need only a handful of TLB entries. With
+ * PGE they are also marked global and survive CR3 reloads. Page tables of
+ * 4 KiB entries are used only where a caller asks for a page-granular
+ * mapping, in which case the covering large page is split. Without PSE the
+ * direct map falls back to 4 KiB pages throughout.
+ */
+
+static pde_t g_kernel_pgdir[PTRS_PER_PGDIR] __attribute__((aligned(PAGE_SIZE)));
+
+static uint32_t g_global_flag = 0;
+
+
+/*
+ * Allocate a zeroed page table
+ * @return      : Physical address of the table, or 0 if memory is exhausted
+ */
+static phys_addr_t pgtable_alloc(void)
+{
+    phys_addr_t pa = page_alloc(0);
+
+    if(0 != pa)
+        memset(__va(pa), 0, PAGE_SIZE);
+
+    return pa;
+}
+
+
+/*
+ * Replace a 4 MiB mapping with a page table describing the same range
+ */
+static kern_return_t split_large_page(pde_t *pde)
+{
+    uint32_t flags = (*pde & PTE_FLAGS_MASK) & ~PDE_LARGE;
+    phys_addr_t base = *pde & LARGE_PAGE_MASK;
+    uintptr_t va = (uintptr_t) (pde - g_kernel_pgdir) << PGDIR_SHIFT;
+    phys_addr_t table = pgtable_alloc();
+    pte_t *pt;
+
+    if(0 == table)
+        return KERN_FAILURE;
+
+    pt = (pte_t *) __va(table);
+    for(int i = 0; i < PTRS_PER_PGTABLE; i++)
+        pt[i] = (base + i*PAGE_SIZE) | flags;
+
+    /* G only has meaning in the leaf entries; the PDE now points at a table */
+    *pde = table | (flags & ~PTE_GLOBAL);
+
+    /*
+     * The old translation may be global, which a CR3 reload leaves in place,
+     * and the TLB may hold it split into 4 KiB pieces; drop every one of them
+     */
+    for(uint32_t off = 0; off < LARGE_PAGE_SIZE; off += PAGE_SIZE)
+        invlpg(va + off);
+
+    return KERN_SUCCESS;
+}
+
+
+kern_return_t paging_map_page(uintptr_t va, phys_addr_t pa, uint32_t flags)
+{
+    pde_t *pde = &g_kernel_pgdir[PGDIR_INDEX(va)];
+    pte_t *pt;
+
+    if(!(*pde & PTE_PRESENT)){
+        phys_addr_t table = pgtable_alloc();
+        if(0 == table)
+            return KERN_FAILURE;
+
+        *pde = table | PTE_PRESENT | PTE_RW;
+    }else if(*pde & PDE_LARGE){
+        if(KERN_SUCCESS != split_large_page(pde))
+            return KERN_FAILURE;
+    }
+
+    pt = (pte_t *) __va(*pde & PAGE_MASK);
+    pt[PGTABLE_INDEX(va)] = (pa & PAGE_MASK) | (flags & PTE_FLAGS_MASK);
+    invlpg(va);
+
+    return KERN_SUCCESS;
+}
+
+
+void paging_unmap_page(uintptr_t va)
+{
+    pde_t pde = g_kernel_pgdir[PGDIR_INDEX(va)];
+
+    if( !(pde & PTE_PRESENT) || (pde & PDE_LARGE) )
+        return;
+
+    ((pte_t *) __va(pde & PAGE_MASK))[PGTABLE_INDEX(va)] = 0;
+    invlpg(va);
+}
+
+
+phys_addr_t paging_virt_to_phys(uintptr_t va)
+{
+    pde_t pde = g_kernel_pgdir[PGDIR_INDEX(va)];
+    pte_t pte;
+
+    if(!(pde & PTE_PRESENT))
+        return 0;
+
+    if(pde & PDE_LARGE)
+        return (pde & LARGE_PAGE_MASK) | (va & ~LARGE_PAGE_MASK);
+
+    pte = ((pte_t *) __va(pde & PAGE_MASK))[PGTABLE_INDEX(va)];
+    if(!(pte & PTE_PRESENT))
+        return 0;
+
+    return (pte & PAGE_MASK) | (va & ~PAGE_MASK);
+}
+
+
+void *ioremap(phys_addr_t pa, size_t size)
+{
+    static uintptr_t next = IOREMAP_START;
+    phys_addr_t base = pa & PAGE_MASK;
+    uint32_t len = PAGE_ALIGN(pa + size) - base;
+    unsigned long flags;
+    uintptr_t va;
+
+    flags = local_irq_save();
+    if( (0 == size) || (len > IOREMAP_END - next) ){
+        local_irq_restore(flags);
+        return NULL;
+    }
+    va = next;
+    next += len;
+    local_irq_restore(flags);
+
+    for(uint32_t off = 0; off < len; off += PAGE_SIZE){
+        if(KERN_SUCCESS != paging_map_page(va + off, base + off, PAGE_KERNEL_NOCACHE | g_global_flag))
+            return NULL;
+    }
+
+    return (void *) (va + (pa - base));
+}
+
+
+void iounmap(void *va, size_t size)
+{
+    uintptr_t base = (uintptr_t) va & PAGE_MASK;
+    uintptr_t end = PAGE_ALIGN((uintptr_t) va + size);
+
+    for(; base < end; base += PAGE_SIZE)
+        paging_unmap_page(base);
+}
+
+
+/*
+ * Physical memory covered by the direct map, in whole directory entries
+ */
+static phys_addr_t __init direct_map_end(uint32_t max_pfn)
+{
+    uint64_t end = ((uint64_t) max_pfn << PAGE_SHIFT);
+
+    /* Always cover at least the first 4 MiB (kernel image, VGA memory) */
+    end = (end + LARGE_PAGE_SIZE - 1) & ~(uint64_t) (LARGE_PAGE_SIZE - 1);
+    if(0 == end)
+        end = LARGE_PAGE_SIZE;
+    if(end > DIRECT_MAP_SIZE)
+        end = DIRECT_MAP_SIZE;
+
+    return (phys_addr_t) end;
+}
+
+
+size_t __init paging_early_size(uint32_t max_pfn)
+{
+    if(cpu_has(CPU_FEATURE_PSE))
+        return 0;
+
+    /* One page table per 4 MiB of direct map */
+    return (direct_map_end(max_pfn) / LARGE_PAGE_SIZE) * PAGE_SIZE;
+}
+
+
+/*
+ * Map [0, end) at __va() with 4 MiB pages
+ */
+static void __init map_direct_large(phys_addr_t end)
+{
+    for(phys_addr_t pa = 0; pa < end; pa += LARGE_PAGE_SIZE)
+        g_kernel_pgdir[PGDIR_INDEX(__va(pa))] = pa | PAGE_KERNEL | PDE_LARGE | g_global_flag;
+}
+
+
+/*
+ * Map [0, end) at __va() with 4 KiB pages, for CPUs without PSE. The page
+ * tables come from the early area reserved by the caller; the page allocator
+ * may hand out frames that are not mapped yet
+ */
+static void __init map_direct_small(phys_addr_t end, phys_addr_t tables)
+{
+    for(phys_addr_t pa = 0; pa < end; pa += LARGE_PAGE_SIZE){
+        pte_t *pt = (pte_t *) __va(tables);
+
+        for(int i = 0; i < PTRS_PER_PGTABLE; i++)
+            pt[i] = (pa + i*PAGE_SIZE) | PAGE_KERNEL | g_global_flag;
+
+        g_kernel_pgdir[PGDIR_INDEX(__va(pa))] = tables | PAGE_KERNEL;
+        tables += PAGE_SIZE;
+    }
+}
+
+
+void __init paging_init(phys_addr_t early_tables)
+{
+    int pse = cpu_has(CPU_FEATURE_PSE);
+    int pge = cpu_has(CPU_FEATURE_PGE);
+    phys_addr_t end = direct_map_end(g_max_pfn);
+
+    if(pge)
+        g_global_flag = PTE_GLOBAL;
+
+    if(pse)
+        map_direct_large(end);
+    else
+        map_direct_small(end, early_tables);
+
+    if(pse)
+        write_cr4(read_cr4() | CR4_PSE);
+
+    /* Paging is already on (see loader.s); this drops the boot identity mapping */
+    write_cr3(__pa(g_kernel_pgdir));
+
+    /* Global entries only take effect once PGE is set */
+    if(pge)
+        write_cr4(read_cr4() | CR4_PGE);
+
+    printk("Paging: %u MiB direct mapped at 0x%x with %s pages%s\n", end >> 20, PAGE_OFFSET,
+            pse ? "4 MiB" : "4 KiB", pge ? " (global)" : "");
+}
@@ -3,9 +3,11 @@
 #include <stdint.h>
 #include <kernel/tty.h>
 #include <arch/vga.h>
+#include <arch/page.h>
+#include <kernel/init.h>
 
  
-#define VGA_MEM ((uint16_t*) 0xB8000)
+#define VGA_MEM ((uint16_t*) __va(0xB8000))
  
 
 /* Structure representing the current state of the VGA hardware config */
@@ -28,7 +30,7 @@ struct vga_info {
 
 
 //TODO: modeset to higher resolution
-void early_console_init(void)
+void __init early_console_init(void)
 {
 	g_vga.color = vga_entry_color(VGA_COLOR_LIGHT_GREY, VGA_COLOR_BLACK);
     console_clear();
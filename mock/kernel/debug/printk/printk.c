@@ -1,19 +1,32 @@
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <kernel/printk.h>
+#include <kernel/tty.h>
+
+
+/* Hand each formatted run straight to the console */
+static int printk_sink(void *ctx, const char *data, size_t len)
+{
+    (void) ctx;
+    console_write((const uint8_t *) data, len);
+    return 0;
+}
+
+
+int vprintk(const char *format, va_list va)
+{
+    return vcbprintf(printk_sink, NULL, format, va);
+}
 
  
 int printk(const char *format, ...) {
-    static char buf[1024]; //TODO: remove this static buffer requirement
     int ret;
 
     va_list arg;
     va_start(arg, format);
-    vsnprintf(buf, sizeof(buf), format, arg);
+    ret = vprintk(format, arg);
     va_end(arg);
 
-    ret = 0;
-    while(putchar(buf[ret++]) != '\0')
-        ;
-
     return ret;
 }
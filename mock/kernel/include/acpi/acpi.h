@@ -1 +1,33 @@
+#ifndef _ACPI_H
+#define _ACPI_H
+
+#include <stdint.h>
 #include <acpi/rsdp.h>
+
+
+/*
+ * Header common to every ACPI System Description Table
+ */
+struct acpi_sdt_header {
+    char signature[4];
+    uint32_t length;            /* Of the whole table, header included */
+    uint8_t revision;
+    uint8_t checksum;           /* All bytes of the table sum to zero */
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__ ((packed));
+
+
+/*
+ * Locate an ACPI table through the RSDT
+ *
+ * @param signature : Four character table signature (e.g. "APIC")
+ * @return          : A mapping of the validated table, or NULL if not found
+ */
+struct acpi_sdt_header *acpi_find_table(const char *signature);
+
+
+#endif /* _ACPI_H */
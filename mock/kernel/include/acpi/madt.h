@@ -0,0 +1,86 @@
+#ifndef _ACPI_MADT_H
+#define _ACPI_MADT_H
+
+#include <stdint.h>
+#include <acpi/acpi.h>
+
+
+/*
+ * Multiple APIC Description Table (signature "APIC"). The fixed part is
+ * followed by variable length entries describing the interrupt controllers
+ */
+struct acpi_madt {
+    struct acpi_sdt_header header;
+    uint32_t lapic_addr;        /* Physical address of each CPU's local APIC */
+    uint32_t flags;
+} __attribute__ ((packed));
+
+#define ACPI_MADT_PCAT_COMPAT       (1 << 0)    /* Dual 8259s are also installed */
+
+enum acpi_madt_type {
+    ACPI_MADT_LAPIC                 = 0,
+    ACPI_MADT_IOAPIC                = 1,
+    ACPI_MADT_INT_OVERRIDE          = 2,
+    ACPI_MADT_NMI_SOURCE            = 3,
+    ACPI_MADT_LAPIC_NMI             = 4,
+    ACPI_MADT_LAPIC_ADDR_OVERRIDE   = 5,
+};
+
+struct acpi_madt_entry {
+    uint8_t type;
+    uint8_t length;
+} __attribute__ ((packed));
+
+struct acpi_madt_lapic {
+    struct acpi_madt_entry entry;
+    uint8_t acpi_id;
+    uint8_t apic_id;
+    uint32_t flags;
+} __attribute__ ((packed));
+
+#define ACPI_MADT_LAPIC_ENABLED     (1 << 0)
+
+struct acpi_madt_ioapic {
+    struct acpi_madt_entry entry;
+    uint8_t id;
+    uint8_t reserved;
+    uint32_t addr;
+    uint32_t gsi_base;          /* First global system interrupt served by this IOAPIC */
+} __attribute__ ((packed));
+
+/* An ISA IRQ that is not wired to the IOAPIC pin of the same number */
+struct acpi_madt_int_override {
+    struct acpi_madt_entry entry;
+    uint8_t bus;                /* Always 0 (ISA) */
+    uint8_t source;             /* ISA IRQ */
+    uint32_t gsi;
+    uint16_t flags;
+} __attribute__ ((packed));
+
+#define ACPI_MADT_POLARITY_MASK     0x3
+#define ACPI_MADT_POLARITY_LOW      0x3
+#define ACPI_MADT_TRIGGER_MASK      0xc
+#define ACPI_MADT_TRIGGER_LEVEL     0xc
+
+struct acpi_madt_lapic_addr_override {
+    struct acpi_madt_entry entry;
+    uint16_t reserved;
+    uint64_t addr;
+} __attribute__ ((packed));
+
+
+/*
+ * Callback for acpi_madt_foreach
+ * @param entry : The entry; cast according to entry->type
+ * @param ctx   : The context pointer passed to acpi_madt_foreach
+ */
+typedef void (*acpi_madt_fn_t)(const struct acpi_madt_entry *entry, void *ctx);
+
+
+/*
+ * Invoke a callback for every entry of the MADT
+ */
+void acpi_madt_foreach(const struct acpi_madt *madt, acpi_madt_fn_t fn, void *ctx);
+
+
+#endif /* _ACPI_MADT_H */
@@ -1,3 +1,6 @@
+#ifndef _ACPI_RSDP_H
+#define _ACPI_RSDP_H
+
 #include <stdint.h>
 
 
@@ -21,3 +24,6 @@ struct RSDPDescriptor {
  * @return  The address of the RSDP structure, or NULL if not found
  */
 struct RSDPDescriptor* find_rsdp(void);
+
+
+#endif /* _ACPI_RSDP_H */
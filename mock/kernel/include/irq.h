@@ -1,18 +1,134 @@
 #ifndef _IRQ_H
 #define _IRQ_H
 
+#include <stdint.h>
+#include <kern_return.h>
+
 
 typedef unsigned int irq_t;
 typedef void (*irq_handler_t)(void);
 
 
 /*
- * Register an interrupt handler in the given slot 
+ * Handlers on a shared line report whether their device raised the interrupt
+ */
+enum irq_return {
+    IRQ_NONE = 0,
+    IRQ_HANDLED,
+};
+
+/*
+ * Interrupt handler, run with interrupts disabled
+ *
+ * @param irq   : The IRQ line (or vector, see request_vector) the handler was registered for
+ * @param ctx   : The context pointer given at registration
+ */
+typedef enum irq_return (*irq_fn_t)(irq_t irq, void *ctx);
+
+
+/*
+ * Register a handler for a device IRQ line. Several handlers may share a
+ * line; they are run in registration order. The line is unmasked when its
+ * first handler is registered
+ *
+ * @param irq   : IRQ line number, e.g. 0 for the PIT
+ * @param fn    : Handler to run
+ * @param ctx   : Opaque pointer handed to the handler; identifies it to free_irq()
+ * @return      : KERN_SUCCESS, or KERN_FAILURE if out of memory or the line is invalid
+ */
+kern_return_t request_irq(irq_t irq, irq_fn_t fn, void *ctx);
+
+
+/*
+ * Remove the handler registered with the given context. The line is masked
+ * once its last handler is gone
+ */
+void free_irq(irq_t irq, void *ctx);
+
+
+/*
+ * Register/remove a handler for a raw interrupt vector that does not belong
+ * to a device IRQ line (e.g. an exception or a local APIC source)
+ */
+kern_return_t request_vector(unsigned int vector, irq_fn_t fn, void *ctx);
+void free_vector(unsigned int vector, void *ctx);
+
+
+/*
+ * Run the handler chain of a vector. Called by the architecture's common
+ * interrupt entry
+ *
+ * @return      : Non-zero if any handler claimed the interrupt
+ */
+int irq_dispatch(unsigned int vector);
+
+
+/*
+ * Record one interrupt on a vector and how long it took to service, from
+ * entry to EOI. Called by the architecture's common interrupt entry
  *
- * @param handler   A pointer to the interrupt handler
- * @param slot      The requested slot number specific to this system
+ * @param cycles    : Service time in CPU cycles, or 0 if not measured
+ */
+void irq_account(unsigned int vector, uint32_t cycles);
+
+
+/*
+ * Print per-vector interrupt counts and service time histograms, followed by
+ * any statistics the interrupt controller keeps (8259 spurious IRQ7/IRQ15)
+ */
+void irq_stats_dump(void);
+
+
+/*
+ * Number of interrupts taken on a vector since boot
+ */
+uint32_t irq_get_count(unsigned int vector);
+
+
+/*
+ * Record the CPU every device IRQ line is routed to when the controller comes
+ * up, so the balancer starts from where the lines really are
+ */
+void irq_balance_init(unsigned int cpu);
+
+
+/*
+ * Restrict a device IRQ line to a set of CPUs; bit n stands for CPU n. The
+ * line is moved right away if it currently targets a CPU outside the mask
+ *
+ * @return  : KERN_FAILURE if the controller cannot route interrupts or no
+ *            CPU in the mask can take them
+ */
+kern_return_t irq_set_affinity(irq_t irq, uint32_t mask);
+uint32_t irq_get_affinity(irq_t irq);
+
+
+/*
+ * Spread device IRQ lines over the CPUs by their interrupt counts since the
+ * previous pass. irq_balance_schedule() runs a pass from softirq context
+ */
+void irq_balance(void);
+void irq_balance_schedule(void);
+
+/* Seconds between balancing passes */
+#define IRQ_BALANCE_INTERVAL_SEC    10
+
+
+/*
+ * Mask control for device IRQ lines. Direct calls into the controller driver
+ * when the kernel is built for a single interrupt controller
  */
+#include <arch/irq_backend.h>
 
+#ifdef IRQ_BACKEND_STATIC
+static inline void irq_enable(irq_t irq)    { arch_irq_enable(irq); }
+static inline void irq_disable(irq_t irq)   { arch_irq_disable(irq); }
+static inline void irq_setmask(irq_t mask)  { arch_irq_setmask(mask); }
+#else
+void irq_enable(irq_t irq);
+void irq_disable(irq_t irq);
+void irq_setmask(irq_t mask);
+#endif
 
 
 #endif /* _IRQ_H */
@@ -0,0 +1,62 @@
+#ifndef _KERNEL_CLOCKEVENT_H
+#define _KERNEL_CLOCKEVENT_H
+
+#include <stdint.h>
+
+
+#define CLOCK_EVT_FEAT_PERIODIC     (1 << 0)
+#define CLOCK_EVT_FEAT_ONESHOT      (1 << 1)
+
+/*
+ * A timer that can raise an interrupt, either every tick or once after a
+ * given delay. The driver calls event_handler from its interrupt handler;
+ * the tick layer decides what that is
+ */
+struct clock_event_device {
+    const char *name;
+    unsigned int features;      /* CLOCK_EVT_FEAT_* */
+    uint64_t min_delta_ns;
+    uint64_t max_delta_ns;
+    int rating;
+
+    /* Interrupt every 1/HZ seconds */
+    void (*set_periodic)(struct clock_event_device *dev);
+
+    /* Interrupt once, delta_ns from now; clamped to [min_delta_ns, max_delta_ns] by the caller */
+    void (*set_next_event)(uint64_t delta_ns, struct clock_event_device *dev);
+
+    void (*event_handler)(struct clock_event_device *dev);
+};
+
+
+/*
+ * Offer a tick device. The best rated one drives the tick
+ */
+void clockevents_register_device(struct clock_event_device *dev);
+
+
+/*
+ * Start the tick on the registered device, periodic at HZ
+ */
+void tick_init(void);
+
+
+/*
+ * With CONFIG_NO_HZ, switch the tick to one-shot mode: the device is only
+ * programmed for the next deadline. Needs a one-shot capable device and a
+ * clocksource that does not itself depend on the tick
+ *
+ * @return  : 0 on success, -1 if the tick stays periodic
+ */
+int tick_nohz_enable(void);
+
+
+/*
+ * Ask for a timer interrupt no later than 'expires_ns' (ktime_get_ns() time).
+ * Only has an effect in one-shot mode; the periodic tick comes anyway
+ */
+void tick_program_event(uint64_t expires_ns);
+void tick_program_jiffy(uint32_t j);
+
+
+#endif /* _KERNEL_CLOCKEVENT_H */
@@ -0,0 +1,55 @@
+#ifndef _KERNEL_CLOCKSOURCE_H
+#define _KERNEL_CLOCKSOURCE_H
+
+#include <stdint.h>
+
+
+#define NSEC_PER_USEC   1000ull
+#define NSEC_PER_MSEC   1000000ull
+#define NSEC_PER_SEC    1000000000ull
+
+/* Rating of a clocksource that counts timer ticks, and so stops with them */
+#define CLOCKSOURCE_RATING_TICK     100
+
+
+/*
+ * A free-running counter that time can be read from. Cycles convert to
+ * nanoseconds as (cycles * mult) >> shift
+ */
+struct clocksource {
+    const char *name;
+    uint64_t (*read)(void);
+    uint64_t mask;              /* Counter width; deltas are taken modulo this */
+    uint32_t mult;
+    uint32_t shift;
+    int rating;                 /* Higher is better */
+};
+
+
+/*
+ * Offer a clocksource. The best rated one registered so far is used by
+ * ktime_get_ns(); switching keeps the returned time continuous
+ *
+ * @param cs    : Must stay valid for the life of the kernel
+ */
+void clocksource_register(struct clocksource *cs);
+
+
+/*
+ * Fill in cs->mult and cs->shift for a counter running at 'hz'
+ */
+void clocksource_set_hz(struct clocksource *cs, uint64_t hz);
+
+
+/*
+ * Monotonic nanoseconds since the first clocksource was registered, or 0
+ * before that
+ */
+uint64_t ktime_get_ns(void);
+
+
+/* The clocksource in use, or NULL */
+const struct clocksource *clocksource_current(void);
+
+
+#endif /* _KERNEL_CLOCKSOURCE_H */
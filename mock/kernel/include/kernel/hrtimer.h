@@ -0,0 +1,71 @@
+#ifndef _KERNEL_HRTIMER_H
+#define _KERNEL_HRTIMER_H
+
+#include <stdint.h>
+#include <kern_return.h>
+
+
+enum hrtimer_restart {
+    HRTIMER_NORESTART,
+    HRTIMER_RESTART,            /* Re-queue with the (updated) expires */
+};
+
+/*
+ * A one-shot timer with nanosecond resolution. The function runs from the
+ * timer interrupt itself, with interrupts disabled, so it should be short;
+ * anything longer belongs in a tasklet it schedules
+ */
+struct hrtimer {
+    uint64_t expires;           /* ktime_get_ns() time */
+    enum hrtimer_restart (*function)(struct hrtimer *timer);
+    int index;                  /* Position in the queue, -1 when inactive */
+};
+
+
+void hrtimer_init(struct hrtimer *timer, enum hrtimer_restart (*function)(struct hrtimer *timer));
+
+
+/*
+ * (Re)arm a timer for an absolute time; a time in the past fires at once
+ *
+ * @return  : KERN_FAILURE if the queue is full
+ */
+kern_return_t hrtimer_start(struct hrtimer *timer, uint64_t expires_ns);
+
+
+/*
+ * @return  : 1 if the timer was queued, 0 if not
+ */
+int hrtimer_cancel(struct hrtimer *timer);
+
+
+static inline int hrtimer_active(const struct hrtimer *timer)
+{
+    return timer->index >= 0;
+}
+
+
+/*
+ * Run every expired timer and program the next event. Called from the
+ * hrtimer device's interrupt
+ */
+void hrtimer_run_queues(void);
+
+
+/*
+ * Called on every tick interrupt; runs the queues if there is no dedicated
+ * hrtimer device
+ */
+void hrtimer_tick(void);
+
+
+struct clock_event_device;
+
+/*
+ * Hand the hrtimers a one-shot device of their own. Without one they are
+ * served by the tick: exactly in tickless mode, on the next tick otherwise
+ */
+void hrtimer_register_device(struct clock_event_device *dev);
+
+
+#endif /* _KERNEL_HRTIMER_H */
@@ -0,0 +1,27 @@
+#ifndef _KERNEL_INIT_H
+#define _KERNEL_INIT_H
+
+
+/*
+ * Code and data only needed while booting. The linker script gathers these
+ * sections between __init_start and __init_end, and free_initmem() hands the
+ * pages back to the page allocator once boot is complete. Nothing marked
+ * with these may be referenced afterwards
+ */
+#define __init          __attribute__((section(".init.text"), cold))
+#define __initdata      __attribute__((section(".init.data")))
+
+
+/* Section boundaries provided by the linker script */
+extern char __init_start[];
+extern char __init_end[];
+
+
+/*
+ * Release the memory occupied by __init code and __initdata. Must be called
+ * after the last __init function has returned
+ */
+void free_initmem(void);
+
+
+#endif /* _KERNEL_INIT_H */
@@ -0,0 +1,49 @@
+#ifndef _KERNEL_JIFFIES_H
+#define _KERNEL_JIFFIES_H
+
+#include <stdint.h>
+#include <kernel/clocksource.h>
+
+
+/*
+ * Timer tick rate, chosen at build time (e.g. make HZ=1000)
+ */
+#ifndef CONFIG_HZ
+#define CONFIG_HZ       100
+#endif
+
+#define HZ              CONFIG_HZ
+#define TICK_NSEC       ((uint32_t) ((NSEC_PER_SEC + HZ / 2) / HZ))
+
+
+/*
+ * Ticks since the tick was started. In tickless mode it is brought up to date
+ * from the clocksource whenever the timer interrupt does fire.
+ *
+ * g_jiffies is the low half of the 64-bit count. It can be read directly,
+ * but wraps (after 49 days at HZ=1000), so only compare it with the
+ * time_after() family. get_jiffies_64() never wraps in practice; it reads
+ * the full count under the tick's sequence counter
+ */
+extern volatile uint32_t g_jiffies;
+
+uint64_t get_jiffies_64(void);
+
+
+/*
+ * Monotonic time as of the last tick: cheaper than ktime_get_ns(), which
+ * reads the clocksource, but only as precise as the tick
+ */
+uint64_t ktime_get_coarse_ns(void);
+
+
+/* Wrap-safe comparisons of jiffies values */
+#define time_after(a, b)        ((int32_t) ((b) - (a)) < 0)
+#define time_after_eq(a, b)     ((int32_t) ((a) - (b)) >= 0)
+#define time_before(a, b)       time_after(b, a)
+
+#define time_after64(a, b)      ((int64_t) ((b) - (a)) < 0)
+#define time_before64(a, b)     time_after64(b, a)
+
+
+#endif /* _KERNEL_JIFFIES_H */
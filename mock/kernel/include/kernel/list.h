@@ -0,0 +1,92 @@
+#ifndef _KERNEL_LIST_H
+#define _KERNEL_LIST_H
+
+#include <stddef.h>
+
+
+/*
+ * Intrusive, circular doubly-linked list. Embed a struct list_head in the
+ * containing object and recover the object with list_entry()
+ */
+struct list_head {
+    struct list_head *next;
+    struct list_head *prev;
+};
+
+
+#define container_of(ptr, type, member) \
+    ((type *) ((char *) (ptr) - offsetof(type, member)))
+
+#define list_entry(ptr, type, member)   container_of(ptr, type, member)
+
+#define list_first_entry(head, type, member) \
+    list_entry((head)->next, type, member)
+
+#define LIST_HEAD_INIT(name)            { &(name), &(name) }
+
+#define list_for_each_entry(pos, head, member)                          \
+    for(pos = list_entry((head)->next, __typeof__(*pos), member);       \
+        &pos->member != (head);                                         \
+        pos = list_entry(pos->member.next, __typeof__(*pos), member))
+
+
+static inline void list_init(struct list_head *head)
+{
+    head->next = head;
+    head->prev = head;
+}
+
+
+static inline int list_empty(const struct list_head *head)
+{
+    return head->next == head;
+}
+
+
+static inline void __list_insert(struct list_head *entry, struct list_head *prev, struct list_head *next)
+{
+    next->prev = entry;
+    entry->next = next;
+    entry->prev = prev;
+    prev->next = entry;
+}
+
+
+/* Insert after head (stack order) */
+static inline void list_add(struct list_head *entry, struct list_head *head)
+{
+    __list_insert(entry, head, head->next);
+}
+
+
+/* Insert before head (queue order) */
+static inline void list_add_tail(struct list_head *entry, struct list_head *head)
+{
+    __list_insert(entry, head->prev, head);
+}
+
+
+static inline void list_del(struct list_head *entry)
+{
+    entry->next->prev = entry->prev;
+    entry->prev->next = entry->next;
+    entry->next = entry;
+    entry->prev = entry;
+}
+
+
+/* Move every entry of 'list' to the end of 'head', leaving 'list' empty */
+static inline void list_splice_tail_init(struct list_head *list, struct list_head *head)
+{
+    if(list_empty(list))
+        return;
+
+    list->next->prev = head->prev;
+    head->prev->next = list->next;
+    list->prev->next = head;
+    head->prev = list->prev;
+    list_init(list);
+}
+
+
+#endif /* _KERNEL_LIST_H */
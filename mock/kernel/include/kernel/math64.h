@@ -0,0 +1,73 @@
+#ifndef _KERNEL_MATH64_H
+#define _KERNEL_MATH64_H
+
+#include <stdint.h>
+
+
+/*
+ * (a * mul) >> shift for shift <= 32. The product is kept to 96 bits so a full
+ * 64-bit 'a' cannot overflow, using two 32x32->64 multiplies, which is all a
+ * 32-bit CPU has. Since hi is worth 2^32 times lo, no bits below 'shift' are
+ * shared between the two halves and the sum is exact
+ */
+static inline uint64_t mul_u64_u32_shr(uint64_t a, uint32_t mul, unsigned int shift)
+{
+    uint64_t lo = (uint64_t) (uint32_t) a * mul;
+    uint64_t hi = (uint64_t) (uint32_t) (a >> 32) * mul;
+
+    return (lo >> shift) + (hi << (32 - shift));
+}
+
+
+/*
+ * dividend / divisor with the remainder in *remainder. On i386 this is two
+ * divl: the high word first, then the low word with the leftover on top, so
+ * neither quotient can overflow and libgcc's __udivdi3/__umoddi3 stay out of it
+ */
+static inline uint64_t div_u64_rem(uint64_t dividend, uint32_t divisor, uint32_t *remainder)
+{
+#if defined(__i386__)
+    uint32_t hi = (uint32_t) (dividend >> 32);
+    uint32_t lo = (uint32_t) dividend;
+    uint32_t q_hi = hi / divisor;
+
+    hi -= q_hi * divisor;
+    asm("divl %4" : "=a"(lo), "=d"(*remainder) : "a"(lo), "d"(hi), "rm"(divisor));
+
+    return ((uint64_t) q_hi << 32) | lo;
+#else
+    *remainder = (uint32_t) (dividend % divisor);
+    return dividend / divisor;
+#endif
+}
+
+
+/*
+ * Pick mult and shift (<= 32) so that x * to / from ~= (x * mult) >> shift,
+ * with the most precision that keeps mult within 32 bits. For example
+ * from = TSC Hz, to = NSEC_PER_SEC converts cycles to nanoseconds
+ */
+static inline void clocks_calc_mult_shift(uint32_t *mult, uint32_t *shift, uint64_t from, uint64_t to)
+{
+    uint64_t tmp = 0;
+    uint32_t sft;
+
+    for(sft = 32; sft > 0; sft--){
+        /* 'to' shifted this far would not fit */
+        if(0 != (to >> (64 - sft)))
+            continue;
+
+        tmp = ((to << sft) + from / 2) / from;
+        if(0 == (tmp >> 32))
+            break;
+    }
+
+    if(0 == sft)
+        tmp = (to + from / 2) / from;
+
+    *mult = (uint32_t) tmp;
+    *shift = sft;
+}
+
+
+#endif /* _KERNEL_MATH64_H */
@@ -0,0 +1,111 @@
+#ifndef _KERNEL_PAGE_ALLOC_H
+#define _KERNEL_PAGE_ALLOC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <kernel/list.h>
+#include <arch/page.h>
+
+
+/* Largest block handed out: 2^PAGE_MAX_ORDER pages (4 MiB) */
+#define PAGE_MAX_ORDER      10
+
+/* Page flags */
+#define PG_RESERVED         0x01    /* Not managed by the allocator (hole, firmware, kernel image) */
+#define PG_FREE             0x02    /* Head page of a free block */
+#define PG_SLAB             0x04    /* Backs a slab; 'private' points at the slab */
+#define PG_KMALLOC          0x08    /* Head page of a large kmalloc() block */
+
+
+/*
+ * Per-frame bookkeeping; one entry for every physical page up to max_pfn
+ */
+struct page {
+    struct list_head list;  /* Free list linkage while the block is free */
+    uint16_t flags;
+    uint8_t order;          /* Block order; valid on the head page of a block */
+    void *private;          /* Owner-specific data */
+};
+
+
+extern struct page *g_mem_map;
+extern uint32_t g_max_pfn;
+
+
+static inline struct page *pfn_to_page(uint32_t pfn)
+{
+    return &g_mem_map[pfn];
+}
+
+
+static inline uint32_t page_to_pfn(const struct page *page)
+{
+    return page - g_mem_map;
+}
+
+
+static inline struct page *phys_to_page(phys_addr_t addr)
+{
+    return pfn_to_page(addr >> PAGE_SHIFT);
+}
+
+
+static inline phys_addr_t page_to_phys(const struct page *page)
+{
+    return (phys_addr_t) page_to_pfn(page) << PAGE_SHIFT;
+}
+
+
+/*
+ * Number of bytes of struct page array needed to describe max_pfn frames
+ */
+size_t page_alloc_map_size(uint32_t max_pfn);
+
+
+/*
+ * Initialize the buddy allocator. Every frame starts out reserved; usable
+ * memory is then handed over with page_alloc_free_range()
+ *
+ * @param map       : Storage for the frame array, page_alloc_map_size() bytes
+ * @param max_pfn   : One past the highest frame number to manage
+ */
+void page_alloc_init(struct page *map, uint32_t max_pfn);
+
+
+/*
+ * Release the page-aligned physical range [start, end) to the allocator. The
+ * end is 64-bit so that a range reaching the top of the 32-bit space can be
+ * expressed
+ */
+void page_alloc_free_range(phys_addr_t start, uint64_t end);
+
+
+/*
+ * Allocate 2^order physically contiguous, naturally aligned pages
+ *
+ * @param order     : Block order, 0 through PAGE_MAX_ORDER
+ * @return          : Physical address of the block, or 0 if none is available
+ *                    (frame 0 is never handed out)
+ */
+phys_addr_t page_alloc(unsigned int order);
+
+
+/*
+ * Return a block previously obtained from page_alloc() with the same order
+ */
+void page_free(phys_addr_t addr, unsigned int order);
+
+
+/*
+ * Number of free pages currently held by the allocator
+ */
+uint32_t page_alloc_nr_free(void);
+
+
+/*
+ * Print the per-order free block counts
+ */
+void page_alloc_dump(void);
+
+
+#endif /* _KERNEL_PAGE_ALLOC_H */
@@ -1 +1,16 @@
+#ifndef _KERNEL_PRINTK_H
+#define _KERNEL_PRINTK_H
+
+#include <stdarg.h>
+
+
+/*
+ * Format and write a message to the kernel console. Output is streamed to the
+ * console as it is formatted; nothing is buffered
+ * @return      : Number of bytes written
+ */
 int printk(const char* __restrict, ...);
+int vprintk(const char *format, va_list va);
+
+
+#endif /* _KERNEL_PRINTK_H */
@@ -0,0 +1,76 @@
+#ifndef _KERNEL_RING_H
+#define _KERNEL_RING_H
+
+#include <stdint.h>
+
+
+/*
+ * Single-producer/single-consumer ring buffer. The producer only ever writes
+ * 'head' and the consumer only ever writes 'tail', so one side may run in an
+ * interrupt handler and the other outside it without any locking. Both are
+ * free-running counters; the slot is picked by masking, which is why the size
+ * must be a power of two, and head - tail stays correct across wrap-around.
+ *
+ * x86 does not reorder stores with other stores or loads with other loads,
+ * so a compiler barrier is enough to publish a slot before moving an index.
+ *
+ *      static RING(uint8_t, 64) g_ring;
+ *      ring_put(&g_ring, byte);        // producer
+ *      ring_get(&g_ring, &byte);       // consumer
+ */
+#define RING(type, size)                                                \
+    struct {                                                            \
+        volatile uint32_t head;                                         \
+        volatile uint32_t tail;                                         \
+        type buf[size];                                                 \
+    }
+
+#define ring_barrier()      asm volatile("" : : : "memory")
+
+#define ring_size(r)        (sizeof((r)->buf) / sizeof((r)->buf[0]))
+#define ring_mask(r)        (ring_size(r) - 1)
+#define ring_count(r)       ((uint32_t) ((r)->head - (r)->tail))
+#define ring_empty(r)       ((r)->head == (r)->tail)
+#define ring_full(r)        (ring_count(r) >= ring_size(r))
+
+#define ring_check_size(r)                                              \
+    _Static_assert(0 == (ring_size(r) & ring_mask(r)), "ring size must be a power of two")
+
+
+/*
+ * Producer side. Evaluates to 1 when 'val' was stored, 0 when the ring is full
+ */
+#define ring_put(r, val)                                                \
+    ({                                                                  \
+        int __stored = 0;                                               \
+        ring_check_size(r);                                             \
+        if(!ring_full(r)){                                              \
+            (r)->buf[(r)->head & ring_mask(r)] = (val);                 \
+            ring_barrier();                                             \
+            (r)->head++;                                                \
+            __stored = 1;                                               \
+        }                                                               \
+        __stored;                                                       \
+    })
+
+
+/*
+ * Consumer side. Evaluates to 1 when an element was copied to *valp, 0 when
+ * the ring is empty
+ */
+#define ring_get(r, valp)                                               \
+    ({                                                                  \
+        int __got = 0;                                                  \
+        ring_check_size(r);                                             \
+        if(!ring_empty(r)){                                             \
+            ring_barrier();                                             \
+            *(valp) = (r)->buf[(r)->tail & ring_mask(r)];               \
+            ring_barrier();                                             \
+            (r)->tail++;                                                \
+            __got = 1;                                                  \
+        }                                                               \
+        __got;                                                          \
+    })
+
+
+#endif /* _KERNEL_RING_H */
@@ -0,0 +1,67 @@
+#ifndef _KERNEL_SEQLOCK_H
+#define _KERNEL_SEQLOCK_H
+
+#include <stdint.h>
+
+
+/*
+ * Sequence counter. The writer makes the count odd while it updates the data
+ * it guards and even again afterwards. A reader copies the data between
+ * reading the count and checking it again, and retries if the count was odd
+ * or has moved. Readers never block the writer and take no lock. They also
+ * leave interrupts alone, which makes this suitable for data the timer
+ * interrupt publishes, such as a 64-bit value that a 32-bit CPU cannot load
+ * in one go.
+ *
+ * Writers must be serialized against each other and must not be interrupted
+ * by readers on the same CPU; running them with interrupts disabled does both.
+ *
+ * x86 keeps loads in order with other loads and stores with other stores, so
+ * compiler barriers are all the ordering needed.
+ */
+typedef struct {
+    volatile uint32_t sequence;
+} seqcount_t;
+
+#define SEQCNT_ZERO         { .sequence = 0 }
+
+#define seq_barrier()       asm volatile("" : : : "memory")
+
+
+static inline uint32_t read_seqcount_begin(const seqcount_t *s)
+{
+    uint32_t seq;
+
+    while( (seq = s->sequence) & 1 )
+        ;
+
+    seq_barrier();
+    return seq;
+}
+
+
+/*
+ * @return  : Non-zero if the data read since read_seqcount_begin() may be torn
+ */
+static inline int read_seqcount_retry(const seqcount_t *s, uint32_t start)
+{
+    seq_barrier();
+    return s->sequence != start;
+}
+
+
+static inline void write_seqcount_begin(seqcount_t *s)
+{
+    s->sequence++;
+    seq_barrier();
+}
+
+
+static inline void write_seqcount_end(seqcount_t *s)
+{
+    seq_barrier();
+    s->sequence++;
+}
+
+
+#endif /* _KERNEL_SEQLOCK_H */
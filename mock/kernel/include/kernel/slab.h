@@ -0,0 +1,91 @@
+#ifndef _KERNEL_SLAB_H
+#define _KERNEL_SLAB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <kernel/list.h>
+
+
+/*
+ * An object cache: a set of slabs, each a block of pages carved into
+ * equally sized objects. Slabs are kept on one of three lists according to
+ * how many of their objects are handed out
+ */
+struct kmem_cache {
+    const char *name;
+    size_t size;                    /* Object size, rounded up to the alignment */
+    size_t align;
+    unsigned int order;             /* Each slab spans 2^order pages */
+    unsigned int objs_per_slab;
+    void (*ctor)(void *obj);
+
+    struct list_head slabs_partial;
+    struct list_head slabs_full;
+    struct list_head slabs_empty;
+
+    uint32_t nr_active;             /* Objects currently allocated */
+    uint32_t nr_slabs;
+
+    struct list_head caches;        /* Linkage on the global cache list */
+};
+
+
+/*
+ * Initialize the slab allocator and the generic kmalloc() size classes.
+ * Requires the page allocator to be up
+ */
+void slab_init(void);
+
+
+/*
+ * Create a named object cache
+ *
+ * @param name  : Name reported in statistics; must outlive the cache
+ * @param size  : Object size in bytes
+ * @param align : Required object alignment (power of two), or 0 for the default
+ * @param ctor  : Optional constructor run on every object handed out by the cache
+ * @return      : The new cache, or NULL on failure
+ */
+struct kmem_cache *kmem_cache_create(const char *name, size_t size, size_t align, void (*ctor)(void *obj));
+
+
+/*
+ * Destroy a cache, returning its slabs to the page allocator. Every object
+ * must have been freed
+ */
+void kmem_cache_destroy(struct kmem_cache *cache);
+
+
+/*
+ * Allocate an object from a cache
+ * @return      : The object, or NULL if memory is exhausted
+ */
+void *kmem_cache_alloc(struct kmem_cache *cache);
+
+
+/*
+ * Return an object to the cache it was allocated from
+ */
+void kmem_cache_free(struct kmem_cache *cache, void *obj);
+
+
+/*
+ * General purpose allocation. Requests up to KMALLOC_MAX_CACHE_SIZE come from
+ * power-of-two object caches; larger ones are served directly by the page
+ * allocator
+ */
+#define KMALLOC_MIN_SIZE        8
+#define KMALLOC_MAX_CACHE_SIZE  2048
+
+void *kmalloc(size_t size);
+void *kzalloc(size_t size);
+void kfree(void *ptr);
+
+
+/*
+ * Print per-cache statistics
+ */
+void kmem_cache_dump(void);
+
+
+#endif /* _KERNEL_SLAB_H */
@@ -0,0 +1,65 @@
+#ifndef _KERNEL_SOFTIRQ_H
+#define _KERNEL_SOFTIRQ_H
+
+#include <stdint.h>
+
+
+/*
+ * Deferred interrupt work. A top half raises a softirq (or schedules a
+ * tasklet) and returns; the work then runs on the way out of the interrupt,
+ * after the EOI and with interrupts enabled again. Lower numbers run first
+ */
+enum softirq_nr {
+    SOFTIRQ_TIMER,
+    SOFTIRQ_TASKLET,
+    NR_SOFTIRQS
+};
+
+typedef void (*softirq_fn_t)(void);
+
+
+/*
+ * Install the handler for a softirq number
+ */
+void open_softirq(unsigned int nr, softirq_fn_t fn);
+
+
+/*
+ * Mark a softirq pending. Safe to call from interrupt handlers
+ */
+void raise_softirq(unsigned int nr);
+
+
+/*
+ * Run pending softirqs when leaving an interrupt. Called by the
+ * architecture's common interrupt exit with interrupts disabled, after the
+ * EOI. Does nothing if softirqs are already running further down the stack
+ */
+void irq_exit(void);
+
+
+/*
+ * A tasklet is a function queued to run once from softirq context. Scheduling
+ * one that is already queued has no effect. A tasklet may reschedule itself
+ */
+struct tasklet {
+    struct tasklet *next;
+    void (*fn)(void *ctx);
+    void *ctx;
+    int scheduled;
+};
+
+#define TASKLET_INIT(_fn, _ctx) \
+    { .next = NULL, .fn = (_fn), .ctx = (_ctx), .scheduled = 0 }
+
+void tasklet_init(struct tasklet *t, void (*fn)(void *ctx), void *ctx);
+void tasklet_schedule(struct tasklet *t);
+
+
+/*
+ * Set up the softirq layer
+ */
+void softirq_init(void);
+
+
+#endif /* _KERNEL_SOFTIRQ_H */
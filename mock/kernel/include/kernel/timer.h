@@ -0,0 +1,67 @@
+#ifndef _KERNEL_TIMER_H
+#define _KERNEL_TIMER_H
+
+#include <stdint.h>
+#include <kernel/list.h>
+
+
+/*
+ * A one-shot timeout with jiffy resolution. The function runs from softirq
+ * context, with interrupts enabled, on the first tick at or after 'expires'.
+ * It may re-arm its own timer
+ */
+struct timer_list {
+    struct list_head entry;         /* Self-linked when not pending */
+    uint32_t expires;               /* In jiffies */
+    void (*function)(struct timer_list *timer);
+};
+
+
+/*
+ * Prepare a timer; it starts out inactive
+ */
+void timer_setup(struct timer_list *timer, void (*function)(struct timer_list *timer));
+
+
+/*
+ * (Re)arm a timer for an absolute jiffies value, e.g. g_jiffies + HZ / 10
+ *
+ * @return  : 1 if the timer was pending before the call, 0 if not
+ */
+int mod_timer(struct timer_list *timer, uint32_t expires);
+
+
+/*
+ * Deactivate a timer. The function may still be running if called from
+ * another timer, but will not be started again
+ *
+ * @return  : 1 if the timer was pending, 0 if not
+ */
+int del_timer(struct timer_list *timer);
+
+
+static inline int timer_pending(const struct timer_list *timer)
+{
+    return !list_empty(&timer->entry);
+}
+
+
+/*
+ * Called by the tick for every jiffy that passes
+ */
+void timer_tick(void);
+
+
+/*
+ * Earliest jiffy at which a pending timer may expire
+ *
+ * @param next  : Set to that jiffy
+ * @return      : 0 if there is one, -1 if no timer is pending
+ */
+int timer_next_expiry(uint32_t *next);
+
+
+void timer_init(void);
+
+
+#endif /* _KERNEL_TIMER_H */
@@ -21,4 +21,24 @@ int mb_init(struct multiboot_info *mbi, uint32_t magic);
 int mb_check_valid(struct multiboot_info *mbi);
 
 
+/*
+ * Callback for mb_mmap_foreach
+ * @param base  : Physical base address of the region
+ * @param len   : Length of the region in bytes
+ * @param type  : MULTIBOOT_MEMORY_AVAILABLE for usable RAM, anything else is reserved
+ * @param ctx   : The context pointer passed to mb_mmap_foreach
+ */
+typedef void (*mb_mmap_fn_t)(uint64_t base, uint64_t len, uint32_t type, void *ctx);
+
+
+/*
+ * Invoke a callback for every entry of the bootloader's memory map. Does
+ * nothing if the bootloader did not provide one
+ * @param mbi   : Multiboot structure passed to us from the bootloader
+ * @param fn    : Callback to invoke
+ * @param ctx   : Opaque pointer handed to each callback
+ */
+void mb_mmap_foreach(struct multiboot_info *mbi, mb_mmap_fn_t fn, void *ctx);
+
+
 #endif /* _MULTIBOOT_H */
@@ -13,6 +13,13 @@ struct platform {
     void (*irq_disable)(irq_t irq);  
     void (*irq_enable)(irq_t irq);  
     void (*irq_setmask)(irq_t mask);
+    void (*irq_eoi)(unsigned int vector);
+    int (*irq_spurious)(unsigned int vector);   /* Optional */
+    void (*irq_stats_dump)(void);               /* Optional; controller statistics */
+
+    /* Interrupt routing; left NULL if the controller cannot steer lines */
+    kern_return_t (*irq_set_target)(irq_t irq, unsigned int cpu);
+    uint32_t (*irq_cpu_mask)(void);
 
     kern_return_t (*irq_insert)(irq_handler_t handler, irq_t slot);
     kern_return_t (*irq_remove)(irq_t slot);
@@ -0,0 +1,134 @@
+#include <mock.h>
+#include <irq.h>
+#include <kernel/softirq.h>
+#include <arch/irq.h>
+
+/*
+ * IRQ affinity and balancing.
+ *
+ * Each device IRQ has an affinity mask: the CPUs it may be delivered to, with
+ * bit n standing for CPU n. It is routed to exactly one of them at a time.
+ * irq_balance() looks at how many interrupts each line took since the last
+ * pass. It then places the busiest lines first, each on the least loaded
+ * CPU its mask allows. A line stays where it is on a tie, so a steady load
+ * does not make it bounce between CPUs. Only the controller can route lines
+ * (see plat.irq_set_target), so with the 8259 all of this does nothing.
+ */
+
+static uint32_t g_irq_affinity[NR_IRQS] = { [0 ... NR_IRQS - 1] = ~0u };
+static unsigned int g_irq_target[NR_IRQS];
+static uint32_t g_irq_last_count[NR_IRQS];
+
+
+void irq_balance_init(unsigned int cpu)
+{
+    for(irq_t irq = 0; irq < NR_IRQS; irq++)
+        g_irq_target[irq] = cpu;
+}
+
+
+static kern_return_t irq_retarget(irq_t irq, unsigned int cpu)
+{
+    if(KERN_SUCCESS != plat.irq_set_target(irq, cpu))
+        return KERN_FAILURE;
+
+    g_irq_target[irq] = cpu;
+    return KERN_SUCCESS;
+}
+
+
+kern_return_t irq_set_affinity(irq_t irq, uint32_t mask)
+{
+    uint32_t allowed;
+
+    if( (irq >= NR_IRQS) || (NULL == plat.irq_set_target) )
+        return KERN_FAILURE;
+
+    allowed = mask & plat.irq_cpu_mask();
+    if(0 == allowed)
+        return KERN_FAILURE;
+
+    g_irq_affinity[irq] = mask;
+
+    /* Only move the line if its current CPU is no longer allowed */
+    if(!(allowed & (1u << g_irq_target[irq])))
+        return irq_retarget(irq, __builtin_ctz(allowed));
+
+    return KERN_SUCCESS;
+}
+
+
+uint32_t irq_get_affinity(irq_t irq)
+{
+    return (irq < NR_IRQS) ? g_irq_affinity[irq] : 0;
+}
+
+
+void irq_balance(void)
+{
+    uint32_t delta[NR_IRQS], load[32] = {0};
+    irq_t order[NR_IRQS];
+    uint32_t online;
+
+    if(NULL == plat.irq_set_target)
+        return;
+
+    /* Interrupts per line since the last pass, busiest first */
+    for(irq_t irq = 0; irq < NR_IRQS; irq++){
+        uint32_t count = irq_get_count(irq_to_vector(irq));
+        irq_t i;
+
+        delta[irq] = count - g_irq_last_count[irq];
+        g_irq_last_count[irq] = count;
+
+        for(i = irq; (i > 0) && (delta[order[i - 1]] < delta[irq]); i--)
+            order[i] = order[i - 1];
+        order[i] = irq;
+    }
+
+    online = plat.irq_cpu_mask();
+    if(0 == (online & (online - 1)))
+        return;
+
+    for(int i = 0; i < NR_IRQS; i++){
+        irq_t irq = order[i];
+        uint32_t allowed = g_irq_affinity[irq] & online;
+        unsigned int best = g_irq_target[irq];
+
+        /* The rest of the lines were idle */
+        if(0 == delta[irq])
+            break;
+
+        if(0 == allowed)
+            continue;
+
+        if(!(allowed & (1u << best)))
+            best = __builtin_ctz(allowed);
+
+        for(uint32_t m = allowed; 0 != m; m &= m - 1){
+            unsigned int cpu = __builtin_ctz(m);
+
+            if(load[cpu] < load[best])
+                best = cpu;
+        }
+
+        load[best] += delta[irq];
+        if(best != g_irq_target[irq])
+            irq_retarget(irq, best);
+    }
+}
+
+
+static void irq_balance_fn(void *ctx)
+{
+    (void) ctx;
+    irq_balance();
+}
+
+static struct tasklet g_irq_balance_tasklet = TASKLET_INIT(irq_balance_fn, NULL);
+
+
+void irq_balance_schedule(void)
+{
+    tasklet_schedule(&g_irq_balance_tasklet);
+}
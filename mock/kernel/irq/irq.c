@@ -1,6 +1,218 @@
 #include <mock.h>
+#include <irq.h>
+#include <kernel/slab.h>
+#include <arch/irq.h>
+#include <arch/irqflags.h>
 
+/*
+ * Generic interrupt dispatch.
+ *
+ * Every vector has a chain of handlers. The architecture's common entry
+ * stub saves the interrupted state and calls irq_dispatch() with the vector,
+ * which runs the chain. Chains are modified with interrupts disabled, and
+ * dispatch runs with interrupts disabled too, so the two never race.
+ *
+ * Every vector also counts its interrupts. Vectors with handlers keep a
+ * histogram of service times as well, bucketed by log2 of the cycle count:
+ * bucket n holds times in [2^n, 2^(n+1)). Recording one sample costs an
+ * increment and a bit scan. The histograms are allocated when a vector gets
+ * its first handler, so unused vectors cost only their counter.
+ */
 
+#define IRQ_HIST_BUCKETS    32
+
+struct irq_hist {
+    uint32_t bucket[IRQ_HIST_BUCKETS];
+};
+
+struct irq_action {
+    irq_fn_t fn;
+    void *ctx;
+    irq_t irq;                      /* Passed back to fn */
+    struct irq_action *next;
+};
+
+static struct irq_action *g_irq_chains[NR_VECTORS];
+static uint32_t g_irq_counts[NR_VECTORS];
+static struct irq_hist *g_irq_hists[NR_VECTORS];
+
+
+/*
+ * Append a handler to a vector's chain
+ * @return  : 1 if the chain was empty before, 0 if not, -1 on failure
+ */
+static int chain_add(unsigned int vector, irq_t irq, irq_fn_t fn, void *ctx)
+{
+    struct irq_action *action, **link;
+    unsigned long flags;
+    int first;
+
+    if( (vector >= NR_VECTORS) || (NULL == fn) )
+        return -1;
+
+    action = kmalloc(sizeof(*action));
+    if(NULL == action)
+        return -1;
+
+    /* Histograms are kept once a vector is in use, even if its handlers go away later */
+    if(NULL == g_irq_hists[vector]){
+        struct irq_hist *hist = kzalloc(sizeof(*hist));
+
+        if(NULL == hist){
+            kfree(action);
+            return -1;
+        }
+        g_irq_hists[vector] = hist;
+    }
+
+    *action = (struct irq_action) { .fn = fn, .ctx = ctx, .irq = irq, .next = NULL };
+
+    flags = local_irq_save();
+    first = (NULL == g_irq_chains[vector]);
+    for(link = &g_irq_chains[vector]; NULL != *link; link = &(*link)->next)
+        ;
+    *link = action;
+    local_irq_restore(flags);
+
+    return first;
+}
+
+
+/*
+ * Unlink the handler registered with 'ctx'
+ * @return  : 1 if the chain is now empty, 0 if not, -1 if no such handler
+ */
+static int chain_remove(unsigned int vector, void *ctx)
+{
+    struct irq_action *action = NULL, **link;
+    unsigned long flags;
+    int empty;
+
+    if(vector >= NR_VECTORS)
+        return -1;
+
+    flags = local_irq_save();
+    for(link = &g_irq_chains[vector]; NULL != *link; link = &(*link)->next){
+        if((*link)->ctx == ctx){
+            action = *link;
+            *link = action->next;
+            break;
+        }
+    }
+    empty = (NULL == g_irq_chains[vector]);
+    local_irq_restore(flags);
+
+    if(NULL == action)
+        return -1;
+
+    kfree(action);
+    return empty;
+}
+
+
+kern_return_t request_irq(irq_t irq, irq_fn_t fn, void *ctx)
+{
+    int first;
+
+    if(irq >= NR_IRQS)
+        return KERN_FAILURE;
+
+    first = chain_add(irq_to_vector(irq), irq, fn, ctx);
+    if(first < 0)
+        return KERN_FAILURE;
+
+    if(first)
+        irq_enable(irq);
+
+    return KERN_SUCCESS;
+}
+
+
+void free_irq(irq_t irq, void *ctx)
+{
+    if(irq >= NR_IRQS)
+        return;
+
+    if(1 == chain_remove(irq_to_vector(irq), ctx))
+        irq_disable(irq);
+}
+
+
+kern_return_t request_vector(unsigned int vector, irq_fn_t fn, void *ctx)
+{
+    return (chain_add(vector, vector, fn, ctx) < 0) ? KERN_FAILURE : KERN_SUCCESS;
+}
+
+
+void free_vector(unsigned int vector, void *ctx)
+{
+    chain_remove(vector, ctx);
+}
+
+
+int irq_dispatch(unsigned int vector)
+{
+    struct irq_action *action;
+    int handled = 0;
+
+    /* Every handler on a shared line runs; more than one device may be asserting it */
+    for(action = g_irq_chains[vector]; NULL != action; action = action->next){
+        if(IRQ_HANDLED == action->fn(action->irq, action->ctx))
+            handled = 1;
+    }
+
+    return handled;
+}
+
+
+void irq_account(unsigned int vector, uint32_t cycles)
+{
+    struct irq_hist *hist = g_irq_hists[vector];
+
+    g_irq_counts[vector]++;
+
+    if( (NULL != hist) && (0 != cycles) )
+        hist->bucket[31 - __builtin_clz(cycles)]++;
+}
+
+
+uint32_t irq_get_count(unsigned int vector)
+{
+    return (vector < NR_VECTORS) ? g_irq_counts[vector] : 0;
+}
+
+
+void irq_stats_dump(void)
+{
+    printk("vec      count  service cycles (2^n:count)\n");
+
+    for(unsigned int vector = 0; vector < NR_VECTORS; vector++){
+        struct irq_hist *hist = g_irq_hists[vector];
+
+        if(0 == g_irq_counts[vector])
+            continue;
+
+        printk("%3u %10u ", vector, g_irq_counts[vector]);
+        if(NULL != hist){
+            for(int i = 0; i < IRQ_HIST_BUCKETS; i++){
+                if(0 != hist->bucket[i])
+                    printk(" %d:%u", i, hist->bucket[i]);
+            }
+        }
+        printk("\n");
+    }
+
+    /* Whatever the controller keeps of its own, such as 8259 spurious counts */
+#ifdef IRQ_BACKEND_STATIC
+    arch_irq_stats_dump();
+#else
+    if(NULL != plat.irq_stats_dump)
+        plat.irq_stats_dump();
+#endif
+}
+
+
+#ifndef IRQ_BACKEND_STATIC
 void irq_enable(irq_t irq)
 {
     plat.irq_enable(irq);
@@ -17,3 +229,4 @@ void irq_setmask(irq_t mask)
 {
     plat.irq_setmask(mask);
 }
+#endif
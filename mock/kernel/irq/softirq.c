@@ -0,0 +1,123 @@
+#include <mock.h>
+#include <kernel/softirq.h>
+#include <kernel/init.h>
+#include <arch/irqflags.h>
+
+/*
+ * Pending softirqs are bits in a word, written by top halves with interrupts
+ * disabled. irq_exit() takes the whole word, re-enables interrupts and runs
+ * the handlers. Interrupts that arrive meanwhile may raise more bits. Their
+ * own irq_exit() sees softirqs already running and returns, and the outer
+ * loop picks the new bits up. After SOFTIRQ_MAX_RESTART rounds anything
+ * still pending waits for the next interrupt, so a softirq storm cannot
+ * starve the interrupted code.
+ */
+
+#define SOFTIRQ_MAX_RESTART     8
+
+static softirq_fn_t g_softirq_vec[NR_SOFTIRQS];
+static volatile uint32_t g_softirq_pending = 0;
+static int g_softirq_running = 0;
+
+/* FIFO of scheduled tasklets */
+static struct tasklet *g_tasklet_head = NULL;
+static struct tasklet **g_tasklet_tail = &g_tasklet_head;
+
+
+void open_softirq(unsigned int nr, softirq_fn_t fn)
+{
+    assertk(nr < NR_SOFTIRQS);
+    g_softirq_vec[nr] = fn;
+}
+
+
+void raise_softirq(unsigned int nr)
+{
+    unsigned long flags = local_irq_save();
+    g_softirq_pending |= (1u << nr);
+    local_irq_restore(flags);
+}
+
+
+void irq_exit(void)
+{
+    int restart = SOFTIRQ_MAX_RESTART;
+    uint32_t pending;
+
+    if(g_softirq_running || (0 == g_softirq_pending))
+        return;
+
+    g_softirq_running = 1;
+
+    while( (0 != (pending = g_softirq_pending)) && (restart-- > 0) ){
+        g_softirq_pending = 0;
+        local_irq_enable();
+
+        while(0 != pending){
+            unsigned int nr = __builtin_ctz(pending);
+
+            pending &= pending - 1;
+            if(NULL != g_softirq_vec[nr])
+                g_softirq_vec[nr]();
+        }
+
+        local_irq_disable();
+    }
+
+    g_softirq_running = 0;
+}
+
+
+void tasklet_init(struct tasklet *t, void (*fn)(void *ctx), void *ctx)
+{
+    *t = (struct tasklet) TASKLET_INIT(fn, ctx);
+}
+
+
+void tasklet_schedule(struct tasklet *t)
+{
+    unsigned long flags = local_irq_save();
+
+    if(!t->scheduled){
+        t->scheduled = 1;
+        t->next = NULL;
+        *g_tasklet_tail = t;
+        g_tasklet_tail = &t->next;
+        g_softirq_pending |= (1u << SOFTIRQ_TASKLET);
+    }
+
+    local_irq_restore(flags);
+}
+
+
+static void tasklet_action(void)
+{
+    struct tasklet *list;
+    unsigned long flags;
+
+    /* Detach the queue; tasklets scheduled from here on go on a fresh one */
+    flags = local_irq_save();
+    list = g_tasklet_head;
+    g_tasklet_head = NULL;
+    g_tasklet_tail = &g_tasklet_head;
+    local_irq_restore(flags);
+
+    while(NULL != list){
+        struct tasklet *t = list;
+
+        list = t->next;
+
+        /* Cleared first so the tasklet may schedule itself again */
+        flags = local_irq_save();
+        t->scheduled = 0;
+        local_irq_restore(flags);
+
+        t->fn(t->ctx);
+    }
+}
+
+
+void __init softirq_init(void)
+{
+    open_softirq(SOFTIRQ_TASKLET, tasklet_action);
+}
@@ -1,16 +1,36 @@
 #include <mock.h>
 #include <irq.h>
+#include <kernel/init.h>
+#include <kernel/clocksource.h>
+#include <kernel/math64.h>
+#include <arch/irq/keyboard.h>
 
-extern uint32_t time_get_systick(void);
 
 void kernel_main(void)
 {
     printk("\n[%s] \n", __FUNCTION__);
-    plat.irq_enable(0);
-    plat.irq_enable(1);
+    irq_enable(0);
+    irq_enable(1);
     plat.irq_global_enable();
 
+    /* Boot is over; give the init sections back */
+    free_initmem();
+
     while(1){
-        printk("\rsystick: 0x%x", time_get_systick());
+        struct kb_event ev;
+        uint32_t ns;
+        uint64_t sec = div_u64_rem(ktime_get_ns(), NSEC_PER_SEC, &ns);
+
+        printk("\ruptime: %u.%09u s", (uint32_t) sec, ns);
+
+        /* Echo typed characters; F1 prints the interrupt statistics */
+        while(keyboard_read_event(&ev)){
+            if(ev.pressed && (KB_KEY_F1 == ev.keycode)){
+                printk("\n");
+                irq_stats_dump();
+            }else if(ev.pressed && (0 != ev.ascii)){
+                printk("\nkey: '%c' (0x%x)\n", ev.ascii, ev.keycode);
+            }
+        }
     }
 }
@@ -0,0 +1,188 @@
+#include <mock.h>
+#include <kernel/page_alloc.h>
+#include <kernel/init.h>
+
+/*
+ * Binary buddy allocator for physical page frames.
+ *
+ * Free memory is kept as naturally aligned blocks of 2^order pages, one free
+ * list per order. The buddy of the block at frame 'pfn' is at pfn ^ (1 << order);
+ * a freed block is merged with its buddy for as long as the buddy is itself a
+ * free block of the same order. Both allocation and free therefore take at most
+ * PAGE_MAX_ORDER steps, independent of the amount of memory managed.
+ */
+
+struct free_area {
+    struct list_head list;
+    uint32_t nr_free;
+};
+
+struct page *g_mem_map = NULL;
+uint32_t g_max_pfn = 0;
+
+static struct free_area g_free_area[PAGE_MAX_ORDER + 1];
+static uint32_t g_nr_free_pages = 0;
+
+
+static void free_area_add(struct page *page, unsigned int order)
+{
+    page->flags |= PG_FREE;
+    page->order = order;
+    list_add(&page->list, &g_free_area[order].list);
+    g_free_area[order].nr_free++;
+}
+
+
+static void free_area_del(struct page *page, unsigned int order)
+{
+    list_del(&page->list);
+    page->flags &= ~PG_FREE;
+    g_free_area[order].nr_free--;
+}
+
+
+/*
+ * Insert a block into the free lists, coalescing with its buddies
+ */
+static void free_block(uint32_t pfn, unsigned int order)
+{
+    g_nr_free_pages += 1u << order;
+
+    while(order < PAGE_MAX_ORDER){
+        uint32_t buddy_pfn = pfn ^ (1u << order);
+        struct page *buddy;
+
+        if(buddy_pfn >= g_max_pfn)
+            break;
+
+        buddy = pfn_to_page(buddy_pfn);
+        if( !(buddy->flags & PG_FREE) || (buddy->order != order) )
+            break;
+
+        free_area_del(buddy, order);
+        pfn &= ~(1u << order);
+        order++;
+    }
+
+    free_area_add(pfn_to_page(pfn), order);
+}
+
+
+size_t __init page_alloc_map_size(uint32_t max_pfn)
+{
+    return max_pfn * sizeof(struct page);
+}
+
+
+void __init page_alloc_init(struct page *map, uint32_t max_pfn)
+{
+    g_mem_map = map;
+    g_max_pfn = max_pfn;
+    g_nr_free_pages = 0;
+
+    for(unsigned int order = 0; order <= PAGE_MAX_ORDER; order++){
+        list_init(&g_free_area[order].list);
+        g_free_area[order].nr_free = 0;
+    }
+
+    for(uint32_t pfn = 0; pfn < max_pfn; pfn++){
+        struct page *page = pfn_to_page(pfn);
+        list_init(&page->list);
+        page->flags = PG_RESERVED;
+        page->order = 0;
+        page->private = NULL;
+    }
+}
+
+
+void page_alloc_free_range(phys_addr_t start, uint64_t end)
+{
+    uint32_t pfn = PAGE_ALIGN(start) >> PAGE_SHIFT;
+    uint32_t end_pfn = g_max_pfn;
+
+    /* 'end' may be 4 GiB itself, which a phys_addr_t cannot hold */
+    if((end >> PAGE_SHIFT) < end_pfn)
+        end_pfn = (uint32_t) (end >> PAGE_SHIFT);
+
+    /* Frame 0 doubles as the allocation failure value */
+    if(0 == pfn)
+        pfn = 1;
+
+    for(uint32_t i = pfn; i < end_pfn; i++)
+        pfn_to_page(i)->flags &= ~PG_RESERVED;
+
+    /* Hand the range over as the largest naturally aligned blocks that fit */
+    while(pfn < end_pfn){
+        unsigned int order = PAGE_MAX_ORDER;
+
+        while( (pfn & ((1u << order) - 1)) || (pfn + (1u << order) > end_pfn) )
+            order--;
+
+        free_block(pfn, order);
+        pfn += 1u << order;
+    }
+}
+
+
+phys_addr_t page_alloc(unsigned int order)
+{
+    unsigned int current;
+    struct page *page;
+    uint32_t pfn;
+
+    if(order > PAGE_MAX_ORDER)
+        return 0;
+
+    for(current = order; current <= PAGE_MAX_ORDER; current++){
+        if(!list_empty(&g_free_area[current].list))
+            break;
+    }
+
+    if(current > PAGE_MAX_ORDER)
+        return 0;
+
+    page = list_first_entry(&g_free_area[current].list, struct page, list);
+    free_area_del(page, current);
+    pfn = page_to_pfn(page);
+
+    /* Split the block, returning the upper halves to the free lists */
+    while(current > order){
+        current--;
+        free_area_add(pfn_to_page(pfn + (1u << current)), current);
+    }
+
+    page->order = order;
+    g_nr_free_pages -= 1u << order;
+
+    return (phys_addr_t) pfn << PAGE_SHIFT;
+}
+
+
+void page_free(phys_addr_t addr, unsigned int order)
+{
+    uint32_t pfn = addr >> PAGE_SHIFT;
+    struct page *page;
+
+    assertk( (0 == (addr & ~PAGE_MASK)) && (pfn < g_max_pfn) && (order <= PAGE_MAX_ORDER) );
+    assertk( 0 == (pfn & ((1u << order) - 1)) );
+
+    page = pfn_to_page(pfn);
+    assertk( !(page->flags & (PG_FREE | PG_RESERVED)) );
+
+    free_block(pfn, order);
+}
+
+
+uint32_t page_alloc_nr_free(void)
+{
+    return g_nr_free_pages;
+}
+
+
+void page_alloc_dump(void)
+{
+    printk("Free blocks by order:");
+    for(unsigned int order = 0; order <= PAGE_MAX_ORDER; order++)
+        printk(" %u", g_free_area[order].nr_free);
+    printk("\nFree pages: %u (%u KiB)\n", g_nr_free_pages, g_nr_free_pages * (PAGE_SIZE / 1024));
+}
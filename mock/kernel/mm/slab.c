@@ -0,0 +1,350 @@
+#include <mock.h>
+#include <kernel/slab.h>
+#include <kernel/page_alloc.h>
+#include <arch/page.h>
+#include <arch/irqflags.h>
+#include <kernel/init.h>
+
+/*
+ * Slab allocator.
+ *
+ * Each slab is a 2^order page block holding a struct slab header followed by
+ * the objects. Free objects are chained through their first word, so the
+ * free list costs no memory beyond the objects themselves and allocation and
+ * free are a pointer pop/push. Every page of a slab points back at its slab
+ * through struct page, which lets kfree() find the owning cache from a bare
+ * pointer.
+ *
+ * A cache keeps its slabs on partial, full and empty lists. Allocation prefers
+ * partial slabs so that live objects stay packed into as few pages as
+ * possible. At most one empty slab is retained per cache; any further empty
+ * slabs go straight back to the page allocator.
+ */
+
+#define SLAB_MAX_ORDER      3
+#define SLAB_MIN_OBJS       8
+
+struct slab {
+    struct list_head list;
+    struct kmem_cache *cache;
+    void *freelist;
+    unsigned int inuse;
+    void *s_mem;                    /* First object */
+};
+
+/* The cache that kmem_cache descriptors themselves are allocated from */
+static struct kmem_cache g_cache_cache;
+static struct list_head g_cache_list = LIST_HEAD_INIT(g_cache_list);
+
+/* kmalloc() size classes: 8, 16, ..., KMALLOC_MAX_CACHE_SIZE */
+#define KMALLOC_NR_CACHES   9
+static struct kmem_cache *g_kmalloc_caches[KMALLOC_NR_CACHES];
+static const char *g_kmalloc_names[KMALLOC_NR_CACHES] = {
+    "kmalloc-8", "kmalloc-16", "kmalloc-32", "kmalloc-64", "kmalloc-128",
+    "kmalloc-256", "kmalloc-512", "kmalloc-1024", "kmalloc-2048"
+};
+
+
+static size_t slab_header_size(size_t align)
+{
+    return (sizeof(struct slab) + align - 1) & ~(align - 1);
+}
+
+
+static void cache_setup(struct kmem_cache *cache, const char *name, size_t size, size_t align, void (*ctor)(void *))
+{
+    unsigned int order;
+
+    if(0 == align)
+        align = sizeof(void *);
+    if(size < sizeof(void *))
+        size = sizeof(void *);
+
+    cache->name = name;
+    cache->align = align;
+    cache->size = (size + align - 1) & ~(align - 1);
+    cache->ctor = ctor;
+
+    /* Use the smallest slab that holds a reasonable number of objects */
+    for(order = 0; order < SLAB_MAX_ORDER; order++){
+        if( ((PAGE_SIZE << order) - slab_header_size(align)) / cache->size >= SLAB_MIN_OBJS )
+            break;
+    }
+    cache->order = order;
+    cache->objs_per_slab = ((PAGE_SIZE << order) - slab_header_size(align)) / cache->size;
+
+    list_init(&cache->slabs_partial);
+    list_init(&cache->slabs_full);
+    list_init(&cache->slabs_empty);
+    cache->nr_active = 0;
+    cache->nr_slabs = 0;
+
+    list_add_tail(&cache->caches, &g_cache_list);
+}
+
+
+/*
+ * Allocate a fresh slab for a cache and thread its free list
+ */
+static struct slab *cache_grow(struct kmem_cache *cache)
+{
+    phys_addr_t phys = page_alloc(cache->order);
+    struct slab *slab;
+    char *obj;
+
+    if(0 == phys)
+        return NULL;
+
+    slab = (struct slab *) __va(phys);
+    slab->cache = cache;
+    slab->inuse = 0;
+    slab->s_mem = (char *) slab + slab_header_size(cache->align);
+    slab->freelist = NULL;
+
+    /* Thread the list back to front so objects are handed out in address order */
+    obj = (char *) slab->s_mem + cache->objs_per_slab * cache->size;
+    for(unsigned int i = 0; i < cache->objs_per_slab; i++){
+        obj -= cache->size;
+        *(void **) obj = slab->freelist;
+        slab->freelist = obj;
+    }
+
+    for(unsigned int i = 0; i < (1u << cache->order); i++){
+        struct page *page = phys_to_page(phys + i*PAGE_SIZE);
+        page->flags |= PG_SLAB;
+        page->private = slab;
+    }
+
+    list_add(&slab->list, &cache->slabs_empty);
+    cache->nr_slabs++;
+
+    return slab;
+}
+
+
+static void cache_shrink_slab(struct kmem_cache *cache, struct slab *slab)
+{
+    phys_addr_t phys = __pa(slab);
+
+    list_del(&slab->list);
+    for(unsigned int i = 0; i < (1u << cache->order); i++){
+        struct page *page = phys_to_page(phys + i*PAGE_SIZE);
+        page->flags &= ~PG_SLAB;
+        page->private = NULL;
+    }
+
+    cache->nr_slabs--;
+    page_free(phys, cache->order);
+}
+
+
+void *kmem_cache_alloc(struct kmem_cache *cache)
+{
+    unsigned long flags = local_irq_save();
+    struct slab *slab;
+    void *obj;
+
+    if(!list_empty(&cache->slabs_partial)){
+        slab = list_first_entry(&cache->slabs_partial, struct slab, list);
+    }else if(!list_empty(&cache->slabs_empty)){
+        slab = list_first_entry(&cache->slabs_empty, struct slab, list);
+    }else{
+        slab = cache_grow(cache);
+        if(NULL == slab){
+            local_irq_restore(flags);
+            return NULL;
+        }
+    }
+
+    obj = slab->freelist;
+    slab->freelist = *(void **) obj;
+    slab->inuse++;
+    cache->nr_active++;
+
+    list_del(&slab->list);
+    if(slab->inuse == cache->objs_per_slab)
+        list_add(&slab->list, &cache->slabs_full);
+    else
+        list_add(&slab->list, &cache->slabs_partial);
+
+    local_irq_restore(flags);
+
+    if(NULL != cache->ctor)
+        cache->ctor(obj);
+
+    return obj;
+}
+
+
+void kmem_cache_free(struct kmem_cache *cache, void *obj)
+{
+    unsigned long flags;
+    struct page *page;
+    struct slab *slab;
+
+    if(NULL == obj)
+        return;
+
+    page = phys_to_page(__pa(obj));
+    assertk(page->flags & PG_SLAB);
+    slab = (struct slab *) page->private;
+    assertk(slab->cache == cache);
+
+    flags = local_irq_save();
+
+    *(void **) obj = slab->freelist;
+    slab->freelist = obj;
+    slab->inuse--;
+    cache->nr_active--;
+
+    list_del(&slab->list);
+    if(0 == slab->inuse){
+        /* Keep a single empty slab around to absorb alloc/free churn */
+        if(list_empty(&cache->slabs_empty))
+            list_add(&slab->list, &cache->slabs_empty);
+        else
+            cache_shrink_slab(cache, slab);
+    }else{
+        list_add(&slab->list, &cache->slabs_partial);
+    }
+
+    local_irq_restore(flags);
+}
+
+
+struct kmem_cache *kmem_cache_create(const char *name, size_t size, size_t align, void (*ctor)(void *obj))
+{
+    struct kmem_cache *cache;
+
+    if( (0 != align) && (0 != (align & (align - 1))) )
+        return NULL;
+
+    cache = kmem_cache_alloc(&g_cache_cache);
+    if(NULL == cache)
+        return NULL;
+
+    cache_setup(cache, name, size, align, ctor);
+    if(0 == cache->objs_per_slab){
+        list_del(&cache->caches);
+        kmem_cache_free(&g_cache_cache, cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+
+void kmem_cache_destroy(struct kmem_cache *cache)
+{
+    assertk(0 == cache->nr_active);
+
+    while(!list_empty(&cache->slabs_empty))
+        cache_shrink_slab(cache, list_first_entry(&cache->slabs_empty, struct slab, list));
+
+    list_del(&cache->caches);
+    kmem_cache_free(&g_cache_cache, cache);
+}
+
+
+static int kmalloc_index(size_t size)
+{
+    int index = 0;
+    size_t class = KMALLOC_MIN_SIZE;
+
+    while(class < size){
+        class <<= 1;
+        index++;
+    }
+
+    return index;
+}
+
+
+void *kmalloc(size_t size)
+{
+    unsigned int order = 0;
+    unsigned long flags;
+    struct page *page;
+    phys_addr_t phys;
+
+    if(0 == size)
+        return NULL;
+
+    if(size <= KMALLOC_MAX_CACHE_SIZE)
+        return kmem_cache_alloc(g_kmalloc_caches[kmalloc_index(size)]);
+
+    /* Too big for a size class; take whole pages */
+    while((PAGE_SIZE << order) < size)
+        order++;
+
+    /* The buddy lists are shared with cache_grow(), which runs with interrupts off */
+    flags = local_irq_save();
+    phys = page_alloc(order);
+    if(0 != phys){
+        page = phys_to_page(phys);
+        page->flags |= PG_KMALLOC;
+    }
+    local_irq_restore(flags);
+
+    if(0 == phys)
+        return NULL;
+
+    return __va(phys);
+}
+
+
+void *kzalloc(size_t size)
+{
+    void *ptr = kmalloc(size);
+
+    if(NULL != ptr)
+        memset(ptr, 0, size);
+
+    return ptr;
+}
+
+
+void kfree(void *ptr)
+{
+    unsigned long flags;
+    struct page *page;
+
+    if(NULL == ptr)
+        return;
+
+    page = phys_to_page(__pa(ptr));
+    if(page->flags & PG_SLAB){
+        struct slab *slab = (struct slab *) page->private;
+        kmem_cache_free(slab->cache, ptr);
+        return;
+    }
+
+    assertk(page->flags & PG_KMALLOC);
+    flags = local_irq_save();
+    page->flags &= ~PG_KMALLOC;
+    page_free(__pa(ptr), page->order);
+    local_irq_restore(flags);
+}
+
+
+void __init slab_init(void)
+{
+    cache_setup(&g_cache_cache, "kmem_cache", sizeof(struct kmem_cache), 0, NULL);
+
+    for(int i = 0; i < KMALLOC_NR_CACHES; i++){
+        g_kmalloc_caches[i] = kmem_cache_create(g_kmalloc_names[i], KMALLOC_MIN_SIZE << i, 0, NULL);
+        assertk(NULL != g_kmalloc_caches[i]);
+    }
+}
+
+
+void kmem_cache_dump(void)
+{
+    struct kmem_cache *cache;
+
+    printk("%-16s %6s %6s %6s %6s\n", "cache", "size", "active", "slabs", "objs/s");
+    list_for_each_entry(cache, &g_cache_list, caches){
+        printk("%-16s %6u %6u %6u %6u\n", cache->name, (uint32_t) cache->size,
+                cache->nr_active, cache->nr_slabs, cache->objs_per_slab);
+    }
+}
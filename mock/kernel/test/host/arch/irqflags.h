@@ -0,0 +1,37 @@
+#ifndef _ARCH_X86_IRQFLAGS_H
+#define _ARCH_X86_IRQFLAGS_H
+
+/*
+ * Host stand-in for arch/irqflags.h. The unit tests are single threaded and
+ * take no interrupts, so there is nothing to mask
+ */
+
+static inline unsigned long local_irq_save(void)
+{
+    return 0;
+}
+
+
+static inline void local_irq_restore(unsigned long flags)
+{
+    (void) flags;
+}
+
+
+static inline void local_irq_enable(void)
+{
+}
+
+
+static inline void local_irq_disable(void)
+{
+}
+
+
+static inline int irqs_disabled(void)
+{
+    return 0;
+}
+
+
+#endif /* _ARCH_X86_IRQFLAGS_H */
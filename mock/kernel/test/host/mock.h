@@ -0,0 +1,27 @@
+#ifndef _MOCK_H
+#define _MOCK_H
+
+/*
+ * Host stand-in for include/mock.h. Kernel sources built into the unit tests
+ * see printk() and assertk() backed by the C library instead of the console
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include <kern_return.h>
+
+
+#define printk printf
+
+#define assertk(expr) ({                                                    \
+            if(0 == (expr)){                                                \
+                printf("Assert failed: %s:%d\n", __FUNCTION__, __LINE__);   \
+                abort();                                                    \
+            }                                                               \
+        })
+
+
+#endif /* _MOCK_H */
@@ -0,0 +1,37 @@
+#ifndef _TEST_H
+#define _TEST_H
+
+/*
+ * Shared checks for the host-side tests. CHECK() reports a failed condition
+ * with a printf-style message and carries on, so one run lists every
+ * failure (up to a limit) rather than stopping at the first
+ */
+
+#include <stdio.h>
+
+
+static int g_failures = 0;
+
+#define CHECK(cond, ...) do {                                               \
+            if(!(cond)){                                                    \
+                if(g_failures++ < 20){                                      \
+                    printf("FAIL %s:%d: ", __FILE__, __LINE__);             \
+                    printf(__VA_ARGS__);                                    \
+                    printf("\n");                                           \
+                }                                                           \
+            }                                                               \
+        } while(0)
+
+
+/* Prints the failure count; non-zero if any CHECK() failed */
+static inline int test_failed(void)
+{
+    if(0 == g_failures)
+        return 0;
+
+    printf("%d failure(s)\n", g_failures);
+    return 1;
+}
+
+
+#endif /* _TEST_H */
@@ -0,0 +1,205 @@
+/*
+ * Host-side test of the hrtimer queue in time/hrtimer.c.
+ *
+ * Timers are armed, re-armed and cancelled at random, and some restart
+ * themselves. The clock then steps forward in small increments. Each timer
+ * must run the expected number of times and never early. After every run the
+ * heap order must hold, and the hardware must be programmed for the root.
+ * The test also checks the clamping done for a dedicated device, and that a
+ * full queue refuses hrtimer_start() and drops a restart without overrunning.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <test.h>
+
+static uint64_t g_now = 0;
+static uint64_t g_programmed = 0;
+
+uint64_t ktime_get_ns(void)
+{
+    return g_now;
+}
+
+
+void tick_program_event(uint64_t expires_ns)
+{
+    g_programmed = expires_ns;
+}
+
+
+#include "../time/hrtimer.c"
+
+
+#define NR_TIMERS       200
+#define MAX_EXPIRES     100000
+#define RESTART_NS      1000
+
+struct test_timer {
+    struct hrtimer timer;
+    int nr_runs;
+    int restarts;                       /* Times left to restart */
+};
+
+static struct test_timer g_timers[NR_TIMERS];
+
+
+static enum hrtimer_restart test_fn(struct hrtimer *timer)
+{
+    struct test_timer *t = (struct test_timer *) timer;
+
+    t->nr_runs++;
+    CHECK(timer->expires <= g_now, "timer %d ran at %llu, before %llu",
+          (int) (t - g_timers), (unsigned long long) g_now, (unsigned long long) timer->expires);
+
+    if(t->restarts > 0){
+        t->restarts--;
+        timer->expires += RESTART_NS;
+        return HRTIMER_RESTART;
+    }
+
+    return HRTIMER_NORESTART;
+}
+
+
+static void check_heap(void)
+{
+    for(int i = 0; i < g_hrtimer_nr; i++){
+        CHECK(g_hrtimer_heap[i]->index == i, "slot %d holds a timer indexed %d", i, g_hrtimer_heap[i]->index);
+        if(i > 0)
+            CHECK(g_hrtimer_heap[(i - 1) / 2]->expires <= g_hrtimer_heap[i]->expires, "heap order broken at %d", i);
+    }
+}
+
+
+static void test_queue(void)
+{
+    for(int i = 0; i < NR_TIMERS; i++){
+        hrtimer_init(&g_timers[i].timer, test_fn);
+        g_timers[i].restarts = i % 5;
+        CHECK(KERN_SUCCESS == hrtimer_start(&g_timers[i].timer, rand() % MAX_EXPIRES), "start %d", i);
+        CHECK(g_programmed == g_hrtimer_heap[0]->expires, "not programmed for the root after start %d", i);
+    }
+
+    /* Re-arming an active timer moves it rather than adding it twice */
+    for(int i = 0; i < NR_TIMERS; i += 3)
+        hrtimer_start(&g_timers[i].timer, rand() % MAX_EXPIRES);
+    CHECK(NR_TIMERS == g_hrtimer_nr, "%d queued after re-arming", g_hrtimer_nr);
+
+    for(int i = 0; i < NR_TIMERS; i += 7){
+        CHECK(1 == hrtimer_cancel(&g_timers[i].timer), "cancel %d", i);
+        CHECK(0 == hrtimer_cancel(&g_timers[i].timer), "cancel %d twice", i);
+    }
+    check_heap();
+
+    for(g_now = 0; g_now < 2 * MAX_EXPIRES; g_now += 37){
+        hrtimer_run_queues();
+        check_heap();
+        if(0 != g_hrtimer_nr){
+            CHECK(g_hrtimer_heap[0]->expires > g_now, "expired timer left queued at %llu", (unsigned long long) g_now);
+            CHECK(g_programmed == g_hrtimer_heap[0]->expires, "not programmed for the root at %llu", (unsigned long long) g_now);
+        }
+    }
+
+    for(int i = 0; i < NR_TIMERS; i++){
+        int want = (0 == i % 7) ? 0 : 1 + i % 5;
+
+        CHECK(want == g_timers[i].nr_runs, "timer %d ran %d times, wanted %d", i, g_timers[i].nr_runs, want);
+    }
+    CHECK(0 == g_hrtimer_nr, "%d timers still queued", g_hrtimer_nr);
+}
+
+
+static uint64_t g_dev_delta;
+
+static void test_set_next_event(uint64_t delta_ns, struct clock_event_device *dev)
+{
+    (void) dev;
+    g_dev_delta = delta_ns;
+}
+
+
+static void test_device(void)
+{
+    static struct clock_event_device dev = {
+        .name = "test",
+        .features = CLOCK_EVT_FEAT_ONESHOT,
+        .min_delta_ns = 500,
+        .max_delta_ns = 1000000,
+        .set_next_event = test_set_next_event,
+    };
+    struct hrtimer timer;
+
+    g_now = 10000000;
+    hrtimer_register_device(&dev);
+    hrtimer_init(&timer, test_fn);
+
+    hrtimer_start(&timer, g_now + 20000);
+    CHECK(20000 == g_dev_delta, "delta %llu, wanted 20000", (unsigned long long) g_dev_delta);
+    hrtimer_start(&timer, g_now + 10);
+    CHECK(dev.min_delta_ns == g_dev_delta, "delta %llu not raised to the minimum", (unsigned long long) g_dev_delta);
+    hrtimer_start(&timer, g_now + 50000000);
+    CHECK(dev.max_delta_ns == g_dev_delta, "delta %llu not capped to the maximum", (unsigned long long) g_dev_delta);
+    hrtimer_cancel(&timer);
+
+    g_hrtimer_dev = NULL;
+}
+
+
+/* Takes the slot its own timer just left, then asks to be restarted */
+static struct hrtimer g_filler;
+
+static enum hrtimer_restart greedy_fn(struct hrtimer *timer)
+{
+    CHECK(KERN_SUCCESS == hrtimer_start(&g_filler, timer->expires + MAX_EXPIRES), "filler start");
+    timer->expires += RESTART_NS;
+    return HRTIMER_RESTART;
+}
+
+
+static void test_full_queue(void)
+{
+    static struct hrtimer timers[HRTIMER_QUEUE_SIZE];
+    struct hrtimer extra;
+
+    g_now = 0;
+    hrtimer_init(&timers[0], greedy_fn);
+    hrtimer_start(&timers[0], 1);
+    for(int i = 1; i < HRTIMER_QUEUE_SIZE; i++){
+        hrtimer_init(&timers[i], test_fn);
+        hrtimer_start(&timers[i], 2 * MAX_EXPIRES + i);
+    }
+
+    hrtimer_init(&extra, test_fn);
+    CHECK(KERN_FAILURE == hrtimer_start(&extra, 5), "start on a full queue succeeded");
+    CHECK(!hrtimer_active(&extra), "refused timer is queued");
+
+    hrtimer_init(&g_filler, test_fn);
+    g_now = 1;
+    hrtimer_run_queues();
+    CHECK(HRTIMER_QUEUE_SIZE == g_hrtimer_nr, "%d queued, wanted %d", g_hrtimer_nr, HRTIMER_QUEUE_SIZE);
+    CHECK(!hrtimer_active(&timers[0]), "restart into a full queue was not dropped");
+    CHECK(hrtimer_active(&g_filler), "filler not queued");
+    check_heap();
+
+    for(int i = 1; i < HRTIMER_QUEUE_SIZE; i++)
+        hrtimer_cancel(&timers[i]);
+    hrtimer_cancel(&g_filler);
+}
+
+
+int main(void)
+{
+    srand(3);
+
+    test_queue();
+    test_device();
+    test_full_queue();
+
+    if(test_failed())
+        return 1;
+
+    printf("hrtimer: %d timers with restarts and cancels, device clamping and a full queue all behaved\n", NR_TIMERS);
+    return 0;
+}
@@ -0,0 +1,298 @@
+/*
+ * Host-side checks for the word-at-a-time strlen, strncmp and memcmp. Each
+ * routine is compared against a byte-wise reference over every source
+ * alignment, with strings ending on the last byte before an unmapped page
+ * so that any load past the terminator's page faults. A timed RSDP-style
+ * scan (strncmp of "RSD PTR " every 16 bytes, as lib/acpi/rsdp.c does)
+ * reports the throughput against the byte-wise loop.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <test.h>
+
+
+/* The libc routines under test, renamed at build time (see Makefile) */
+size_t libc_strlen(const char *str);
+int libc_strncmp(const char *s1, const char *s2, size_t n);
+int libc_memcmp(const void *a, const void *b, size_t size);
+
+#define MAX_LEN         300
+#define MAX_ALIGN       8
+#define PAGE_TAIL       64
+
+
+static size_t ref_strlen(const char *str)
+{
+    size_t n = 0;
+
+    while(str[n])
+        n++;
+    return n;
+}
+
+
+/* Kept out of line so the timed scan pays a call on both sides */
+static int __attribute__((noinline)) ref_strncmp(const char *s1, const char *s2, size_t n)
+{
+    const unsigned char *c1 = (const unsigned char *) s1;
+    const unsigned char *c2 = (const unsigned char *) s2;
+
+    for(; n; n--, c1++, c2++){
+        if(*c1 != *c2)
+            return (int) *c1 - (int) *c2;
+        if(!*c1)
+            break;
+    }
+    return 0;
+}
+
+
+static int ref_memcmp(const void *aptr, const void *bptr, size_t size)
+{
+    const unsigned char *a = aptr;
+    const unsigned char *b = bptr;
+
+    for(size_t i = 0; i < size; i++){
+        if(a[i] != b[i])
+            return (a[i] < b[i]) ? -1 : 1;
+    }
+    return 0;
+}
+
+
+static int sign(int v)
+{
+    return (v > 0) - (v < 0);
+}
+
+
+/* Non-zero filler, including bytes with the top bit set */
+static unsigned char rand_byte(void)
+{
+    return (unsigned char) (1 + rand() % 255);
+}
+
+
+/*
+ * A page of readable memory followed by an inaccessible one. Buffers placed
+ * to end on the last readable byte fault on any over-read into the next page
+ */
+static unsigned char *guarded_page(void)
+{
+    long page = sysconf(_SC_PAGESIZE);
+    unsigned char *p;
+
+    p = mmap(NULL, 2 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(MAP_FAILED == p || 0 != mprotect(p + page, page, PROT_NONE)){
+        perror("mmap");
+        exit(2);
+    }
+    return p + page;
+}
+
+
+static void test_strlen(void)
+{
+    static char buf[MAX_LEN + MAX_ALIGN + 1];
+    unsigned char *end = guarded_page();
+
+    for(size_t align = 0; align < MAX_ALIGN; align++){
+        for(size_t len = 0; len < MAX_LEN; len++){
+            char *s = buf + align;
+
+            for(size_t i = 0; i < len; i++)
+                s[i] = (char) rand_byte();
+            s[len] = '\0';
+            CHECK(libc_strlen(s) == ref_strlen(s), "strlen align %zu len %zu", align, len);
+        }
+    }
+
+    /* The terminator is the last readable byte */
+    for(size_t len = 0; len < PAGE_TAIL; len++){
+        char *s = (char *) end - len - 1;
+
+        for(size_t i = 0; i < len; i++)
+            s[i] = (char) rand_byte();
+        s[len] = '\0';
+        CHECK(libc_strlen(s) == len, "strlen page end len %zu", len);
+    }
+}
+
+
+static void test_strncmp(void)
+{
+    static char abuf[MAX_LEN + MAX_ALIGN + 1], bbuf[MAX_LEN + MAX_ALIGN + 1];
+    unsigned char *aend = guarded_page();
+    unsigned char *bend = guarded_page();
+
+    for(size_t aalign = 0; aalign < MAX_ALIGN; aalign++){
+        for(size_t balign = 0; balign < MAX_ALIGN; balign++){
+            for(size_t len = 0; len < MAX_LEN; len += 1 + len / 16){
+                char *a = abuf + aalign;
+                char *b = bbuf + balign;
+                size_t diff = len ? (size_t) rand() % (len + 1) : 0;
+
+                for(size_t i = 0; i < len; i++)
+                    a[i] = b[i] = (char) rand_byte();
+                a[len] = b[len] = '\0';
+
+                /* Equal, then differing at one byte, then b cut short there */
+                for(int round = 0; round < 3; round++){
+                    if(1 == round && diff < len)
+                        b[diff] = (char) rand_byte();
+                    if(2 == round && diff < len)
+                        b[diff] = '\0';
+
+                    for(size_t n = 0; n <= len + 1; n += 1 + n / 8)
+                        CHECK(sign(libc_strncmp(a, b, n)) == sign(ref_strncmp(a, b, n)),
+                              "strncmp align %zu/%zu len %zu n %zu round %d", aalign, balign, len, n, round);
+                    CHECK(sign(libc_strncmp(a, b, (size_t) -1)) == sign(ref_strncmp(a, b, (size_t) -1)),
+                          "strncmp unbounded align %zu/%zu len %zu round %d", aalign, balign, len, round);
+                }
+            }
+        }
+    }
+
+    /* Both strings end on the last readable byte; n allows reading well beyond */
+    for(size_t alen = 0; alen < PAGE_TAIL; alen++){
+        for(size_t blen = 0; blen < PAGE_TAIL; blen += 7){
+            char *a = (char *) aend - alen - 1;
+            char *b = (char *) bend - blen - 1;
+
+            memset(a, 'x', alen);
+            memset(b, 'x', blen);
+            a[alen] = b[blen] = '\0';
+            CHECK(sign(libc_strncmp(a, b, 4 * PAGE_TAIL)) == sign(ref_strncmp(a, b, 4 * PAGE_TAIL)),
+                  "strncmp page end len %zu/%zu", alen, blen);
+        }
+    }
+}
+
+
+static void test_memcmp(void)
+{
+    static unsigned char abuf[MAX_LEN + MAX_ALIGN], bbuf[MAX_LEN + MAX_ALIGN];
+    unsigned char *aend = guarded_page();
+    unsigned char *bend = guarded_page();
+
+    for(size_t aalign = 0; aalign < MAX_ALIGN; aalign++){
+        for(size_t balign = 0; balign < MAX_ALIGN; balign++){
+            for(size_t len = 0; len < MAX_LEN; len += 1 + len / 16){
+                unsigned char *a = abuf + aalign;
+                unsigned char *b = bbuf + balign;
+
+                for(size_t i = 0; i < len; i++)
+                    a[i] = b[i] = rand_byte();
+                CHECK(0 == libc_memcmp(a, b, len), "memcmp equal align %zu/%zu len %zu", aalign, balign, len);
+
+                /* Embedded NULs must not stop the comparison */
+                if(len){
+                    size_t diff = (size_t) rand() % len;
+
+                    a[len / 2] = b[len / 2] = 0;
+                    b[diff] = (unsigned char) (a[diff] ^ (1u << (rand() % 8)));
+                    CHECK(sign(libc_memcmp(a, b, len)) == ref_memcmp(a, b, len),
+                          "memcmp align %zu/%zu len %zu diff %zu", aalign, balign, len, diff);
+                    CHECK(sign(libc_memcmp(b, a, len)) == ref_memcmp(b, a, len),
+                          "memcmp swapped align %zu/%zu len %zu diff %zu", aalign, balign, len, diff);
+                }
+            }
+        }
+    }
+
+    /* Both buffers end on the last readable byte */
+    for(size_t len = 0; len < PAGE_TAIL; len++){
+        unsigned char *a = aend - len;
+        unsigned char *b = bend - len;
+
+        memset(a, 0x5a, len);
+        memset(b, 0x5a, len);
+        CHECK(0 == libc_memcmp(a, b, len), "memcmp page end len %zu", len);
+        if(len){
+            b[len - 1] = 0xa5;
+            CHECK(sign(libc_memcmp(a, b, len)) == ref_memcmp(a, b, len), "memcmp page end diff len %zu", len);
+        }
+    }
+}
+
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/*
+ * The RSDP lives on a 16-byte boundary in the 128KiB BIOS area. Fill it with
+ * ROM-like noise, plant near-misses on every boundary so that each compare
+ * gets past the first bytes, and put the real signature in the last slot
+ */
+#define RSDP_AREA       (128 * 1024)
+#define RSDP_SIG        "RSD PTR "
+#define RSDP_REPS       2000
+
+static size_t scan_rsdp(const unsigned char *area, int (*cmp)(const char *, const char *, size_t))
+{
+    for(size_t off = 0; off < RSDP_AREA; off += 16){
+        if(0 == cmp(RSDP_SIG, (const char *) area + off, sizeof(RSDP_SIG) - 1))
+            return off;
+    }
+    return RSDP_AREA;
+}
+
+
+static void bench_rsdp(void)
+{
+    unsigned char *area = malloc(RSDP_AREA);
+    volatile size_t sink = 0;
+    double t0, tref, tlibc;
+
+    for(size_t i = 0; i < RSDP_AREA; i++)
+        area[i] = rand_byte();
+    for(size_t off = 0; off < RSDP_AREA; off += 16)
+        memcpy(area + off, "RSD PTX", 7);
+    memcpy(area + RSDP_AREA - 16, RSDP_SIG, sizeof(RSDP_SIG) - 1);
+
+    CHECK(RSDP_AREA - 16 == scan_rsdp(area, libc_strncmp), "rsdp scan offset");
+
+    t0 = now();
+    for(int i = 0; i < RSDP_REPS; i++)
+        sink += scan_rsdp(area, ref_strncmp);
+    tref = now() - t0;
+
+    t0 = now();
+    for(int i = 0; i < RSDP_REPS; i++)
+        sink += scan_rsdp(area, libc_strncmp);
+    tlibc = now() - t0;
+
+    printf("rsdp scan: byte-wise %.1f us, libc %.1f us per %dKiB pass (%.2fx)\n",
+           tref * 1e6 / RSDP_REPS, tlibc * 1e6 / RSDP_REPS, RSDP_AREA / 1024, tref / tlibc);
+    (void) sink;
+    free(area);
+}
+
+
+int main(void)
+{
+    srand(1);
+
+    test_strlen();
+    test_strncmp();
+    test_memcmp();
+    bench_rsdp();
+
+    if(test_failed())
+        return 1;
+
+    printf("all string tests passed\n");
+    return 0;
+}
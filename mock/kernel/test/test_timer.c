@@ -0,0 +1,180 @@
+/*
+ * Host-side test of the timer wheel in time/timer.c.
+ *
+ * A few thousand timers are armed at mixed distances, covering tv1 through
+ * tv5. Some are cancelled and some re-arm themselves from their handler.
+ * Jiffies then advance one at a time from just below the 32-bit wrap until
+ * only tv5 timers are left. After that they jump straight to
+ * timer_next_expiry(), as a tickless kernel would. Each live timer must run
+ * exactly once, on its expiry jiffy, and timer_next_expiry() must never
+ * report a jiffy later than a pending timer.
+ */
+
+#include <stdint.h>
+#include <kernel/softirq.h>
+#include <test.h>
+
+volatile uint32_t g_jiffies = 0xfffff000u;
+
+static softirq_fn_t g_timer_softirq;
+
+void open_softirq(unsigned int nr, softirq_fn_t fn)
+{
+    (void) nr;
+    g_timer_softirq = fn;
+}
+
+
+void raise_softirq(unsigned int nr)
+{
+    (void) nr;
+}
+
+
+void tick_program_jiffy(uint32_t j)
+{
+    (void) j;
+}
+
+
+#include "../time/timer.c"
+
+
+#define NR_TIMERS       3000
+#define MAX_DELTA       (1u << 21)      /* Reaches into tv4 */
+#define TV5_DELTA       (1u << 26)      /* Where tv5 starts */
+#define MAX_FAR_DELTA   (1u << 30)
+
+struct test_timer {
+    struct timer_list timer;
+    uint32_t want;                      /* Jiffy it must run on */
+    uint32_t ran_at;
+    int nr_runs;
+    int rearm;                          /* Re-arm once from the handler */
+    int cancelled;
+};
+
+static struct test_timer g_timers[NR_TIMERS];
+static uint32_t g_start;
+
+
+/* A timer armed for the current jiffy (or earlier) runs on the next one */
+static uint32_t due(uint32_t expires)
+{
+    return time_after(expires, g_start) ? expires : g_start + 1;
+}
+
+
+static void test_fn(struct timer_list *timer)
+{
+    struct test_timer *t = container_of(timer, struct test_timer, timer);
+
+    t->nr_runs++;
+    t->ran_at = g_jiffies;
+    CHECK(g_jiffies == t->want, "timer %d ran at %u, wanted %u", (int) (t - g_timers), g_jiffies, t->want);
+
+    if(t->rearm){
+        t->rearm = 0;
+        t->nr_runs = 0;
+        t->want = g_jiffies + 1 + rand() % 5000;
+        mod_timer(timer, t->want);
+    }
+}
+
+
+static void check_next_expiry(void)
+{
+    uint32_t next;
+
+    if(0 != timer_next_expiry(&next)){
+        CHECK(0 == g_timer_base.nr_pending, "no next expiry with %u pending", g_timer_base.nr_pending);
+        return;
+    }
+
+    for(int i = 0; i < NR_TIMERS; i++){
+        struct test_timer *t = &g_timers[i];
+
+        if(timer_pending(&t->timer) && time_before(t->timer.expires, next)){
+            CHECK(0, "next expiry %u is after timer %d at %u", next, i, t->timer.expires);
+            return;
+        }
+    }
+}
+
+
+int main(void)
+{
+    srand(1);
+    timer_init();
+    g_start = g_jiffies;
+
+    for(int i = 0; i < NR_TIMERS; i++){
+        struct test_timer *t = &g_timers[i];
+        uint32_t delta;
+
+        if(3 == i % 10)
+            delta = TV5_DELTA + rand() % (MAX_FAR_DELTA - TV5_DELTA);
+        else if(0 == i % 3)
+            delta = rand() % 300;
+        else if(1 == i % 3)
+            delta = rand() % 20000;
+        else
+            delta = rand() % MAX_DELTA;
+
+        timer_setup(&t->timer, test_fn);
+        t->want = due(g_start + delta);
+        t->rearm = (0 == i % 7);
+        mod_timer(&t->timer, g_start + delta);
+    }
+
+    /* Move some timers, then cancel others */
+    for(int i = 0; i < NR_TIMERS; i += 5){
+        uint32_t delta = rand() % MAX_DELTA;
+
+        CHECK(1 == mod_timer(&g_timers[i].timer, g_start + delta), "timer %d was not pending", i);
+        g_timers[i].want = due(g_start + delta);
+    }
+
+    for(int i = 1; i < NR_TIMERS; i += 22){
+        CHECK(1 == del_timer(&g_timers[i].timer), "timer %d was not pending", i);
+        CHECK(0 == del_timer(&g_timers[i].timer), "timer %d cancelled twice", i);
+        g_timers[i].cancelled = 1;
+    }
+
+    for(uint32_t n = 0; n < MAX_DELTA + 6000; n++){
+        if(0 == n % 31)
+            check_next_expiry();
+
+        g_jiffies++;
+        timer_tick();
+        g_timer_softirq();
+    }
+
+    /* Only tv5 timers are left; skip the idle stretches between them */
+    for(uint32_t next; 0 == timer_next_expiry(&next); ){
+        check_next_expiry();
+        CHECK(time_after(next, g_jiffies), "next expiry %u is not after %u", next, g_jiffies);
+        if(!time_after(next, g_jiffies))
+            break;
+
+        g_jiffies = next;
+        timer_tick();
+        g_timer_softirq();
+    }
+
+    for(int i = 0; i < NR_TIMERS; i++){
+        struct test_timer *t = &g_timers[i];
+
+        if(t->cancelled)
+            CHECK(0 == t->nr_runs, "cancelled timer %d ran", i);
+        else
+            CHECK(1 == t->nr_runs, "timer %d ran %d times", i, t->nr_runs);
+    }
+    CHECK(0 == g_timer_base.nr_pending, "%u timers still pending", g_timer_base.nr_pending);
+
+    if(test_failed())
+        return 1;
+
+    printf("timer wheel: %d timers up to 2^30 jiffies out, across the wrap, all ran on time\n", NR_TIMERS);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <mock.h>
+#include <kernel/clocksource.h>
+#include <kernel/math64.h>
+#include <kernel/seqlock.h>
+#include <arch/irqflags.h>
+
+/*
+ * ktime_get_ns() reads the current clocksource and scales the cycles that
+ * have passed since a base point with one multiply and shift. When a better
+ * source is registered, the base moves to "now" on the new counter, so time
+ * keeps counting from where the old source left off. The source and its base
+ * are 64-bit state that a 32-bit CPU cannot read in one go, so they are
+ * published under a sequence counter.
+ */
+
+static seqcount_t g_cs_seq = SEQCNT_ZERO;
+static struct clocksource *g_clocksource = NULL;
+static uint64_t g_cs_base_cycles = 0;
+static uint64_t g_cs_base_ns = 0;
+
+
+static inline uint64_t cs_delta_ns(const struct clocksource *cs, uint64_t base_cycles, uint64_t now)
+{
+    return mul_u64_u32_shr((now - base_cycles) & cs->mask, cs->mult, cs->shift);
+}
+
+
+uint64_t ktime_get_ns(void)
+{
+    struct clocksource *cs;
+    uint64_t ns;
+    uint32_t seq;
+
+    do{
+        seq = read_seqcount_begin(&g_cs_seq);
+        cs = g_clocksource;
+        ns = (NULL == cs) ? 0 : g_cs_base_ns + cs_delta_ns(cs, g_cs_base_cycles, cs->read());
+    }while(read_seqcount_retry(&g_cs_seq, seq));
+
+    return ns;
+}
+
+
+void clocksource_set_hz(struct clocksource *cs, uint64_t hz)
+{
+    clocks_calc_mult_shift(&cs->mult, &cs->shift, hz, NSEC_PER_SEC);
+}
+
+
+void clocksource_register(struct clocksource *cs)
+{
+    unsigned long flags;
+
+    if( (NULL != g_clocksource) && (g_clocksource->rating >= cs->rating) )
+        return;
+
+    flags = local_irq_save();
+    write_seqcount_begin(&g_cs_seq);
+
+    if(NULL != g_clocksource)
+        g_cs_base_ns += cs_delta_ns(g_clocksource, g_cs_base_cycles, g_clocksource->read());
+
+    g_cs_base_cycles = cs->read();
+    g_clocksource = cs;
+
+    write_seqcount_end(&g_cs_seq);
+    local_irq_restore(flags);
+
+    printk("clocksource: %s (mult %u, shift %u)\n", cs->name, cs->mult, cs->shift);
+}
+
+
+const struct clocksource *clocksource_current(void)
+{
+    return g_clocksource;
+}
@@ -0,0 +1,225 @@
+#include <mock.h>
+#include <kernel/hrtimer.h>
+#include <kernel/clockevent.h>
+#include <kernel/clocksource.h>
+#include <arch/irqflags.h>
+
+/*
+ * High resolution timers.
+ *
+ * Pending timers form a binary min-heap on their expiry time. The earliest
+ * one is always at the root, so programming the hardware only looks at the
+ * root. Arming or cancelling a timer costs O(log n) sifts, and each timer
+ * records its own heap slot, so cancelling needs no search. The queue is a
+ * fixed array and is not allocated at runtime.
+ *
+ * The hardware is programmed for the root only. That is either a dedicated
+ * one-shot device (the LAPIC in TSC-deadline mode) or, failing that, the
+ * tick device through tick_program_event().
+ */
+
+#define HRTIMER_QUEUE_SIZE      256
+
+static struct hrtimer *g_hrtimer_heap[HRTIMER_QUEUE_SIZE];
+static int g_hrtimer_nr = 0;
+
+static struct clock_event_device *g_hrtimer_dev = NULL;
+
+
+static inline void heap_set(int i, struct hrtimer *timer)
+{
+    g_hrtimer_heap[i] = timer;
+    timer->index = i;
+}
+
+
+static void heap_sift_up(int i)
+{
+    struct hrtimer *timer = g_hrtimer_heap[i];
+
+    while(i > 0){
+        int parent = (i - 1) / 2;
+
+        if(g_hrtimer_heap[parent]->expires <= timer->expires)
+            break;
+
+        heap_set(i, g_hrtimer_heap[parent]);
+        i = parent;
+    }
+
+    heap_set(i, timer);
+}
+
+
+static void heap_sift_down(int i)
+{
+    struct hrtimer *timer = g_hrtimer_heap[i];
+
+    for(;;){
+        int child = 2 * i + 1;
+
+        if(child >= g_hrtimer_nr)
+            break;
+
+        if( (child + 1 < g_hrtimer_nr) && (g_hrtimer_heap[child + 1]->expires < g_hrtimer_heap[child]->expires) )
+            child++;
+
+        if(timer->expires <= g_hrtimer_heap[child]->expires)
+            break;
+
+        heap_set(i, g_hrtimer_heap[child]);
+        i = child;
+    }
+
+    heap_set(i, timer);
+}
+
+
+static void heap_remove(struct hrtimer *timer)
+{
+    int i = timer->index;
+    struct hrtimer *last = g_hrtimer_heap[--g_hrtimer_nr];
+
+    timer->index = -1;
+    if(last == timer)
+        return;
+
+    /* Fill the hole with the last entry and let it find its place */
+    heap_set(i, last);
+    if( (i > 0) && (g_hrtimer_heap[(i - 1) / 2]->expires > last->expires) )
+        heap_sift_up(i);
+    else
+        heap_sift_down(i);
+}
+
+
+/*
+ * Point the hardware at the earliest timer. Called with interrupts disabled
+ */
+static void hrtimer_reprogram(void)
+{
+    uint64_t expires, now;
+
+    if(0 == g_hrtimer_nr)
+        return;
+
+    expires = g_hrtimer_heap[0]->expires;
+
+    if(NULL == g_hrtimer_dev){
+        tick_program_event(expires);
+        return;
+    }
+
+    now = ktime_get_ns();
+    expires = (expires > now) ? expires - now : 0;
+
+    if(expires < g_hrtimer_dev->min_delta_ns)
+        expires = g_hrtimer_dev->min_delta_ns;
+    if(expires > g_hrtimer_dev->max_delta_ns)
+        expires = g_hrtimer_dev->max_delta_ns;
+
+    g_hrtimer_dev->set_next_event(expires, g_hrtimer_dev);
+}
+
+
+void hrtimer_init(struct hrtimer *timer, enum hrtimer_restart (*function)(struct hrtimer *timer))
+{
+    timer->expires = 0;
+    timer->function = function;
+    timer->index = -1;
+}
+
+
+kern_return_t hrtimer_start(struct hrtimer *timer, uint64_t expires_ns)
+{
+    unsigned long flags = local_irq_save();
+    struct hrtimer *first = (0 != g_hrtimer_nr) ? g_hrtimer_heap[0] : NULL;
+
+    if(hrtimer_active(timer)){
+        heap_remove(timer);
+    }else if(HRTIMER_QUEUE_SIZE == g_hrtimer_nr){
+        local_irq_restore(flags);
+        return KERN_FAILURE;
+    }
+
+    timer->expires = expires_ns;
+    heap_set(g_hrtimer_nr++, timer);
+    heap_sift_up(timer->index);
+
+    /* Only a change of the earliest deadline needs the hardware */
+    if( (g_hrtimer_heap[0] != first) || (timer == first) )
+        hrtimer_reprogram();
+
+    local_irq_restore(flags);
+    return KERN_SUCCESS;
+}
+
+
+int hrtimer_cancel(struct hrtimer *timer)
+{
+    unsigned long flags = local_irq_save();
+    int was_active = hrtimer_active(timer);
+
+    /* Leaving the hardware armed for a cancelled root costs one spurious wakeup, no more */
+    if(was_active)
+        heap_remove(timer);
+
+    local_irq_restore(flags);
+    return was_active;
+}
+
+
+void hrtimer_run_queues(void)
+{
+    unsigned long flags = local_irq_save();
+    uint64_t now = ktime_get_ns();
+
+    while( (0 != g_hrtimer_nr) && (g_hrtimer_heap[0]->expires <= now) ){
+        struct hrtimer *timer = g_hrtimer_heap[0];
+
+        heap_remove(timer);
+
+        if( (HRTIMER_RESTART == timer->function(timer)) && !hrtimer_active(timer) ){
+            /* The handler may have started other timers and filled the slot it left */
+            if(HRTIMER_QUEUE_SIZE == g_hrtimer_nr){
+                printk("hrtimer: queue full, dropping restart of %p\n", timer);
+            }else{
+                heap_set(g_hrtimer_nr++, timer);
+                heap_sift_up(timer->index);
+            }
+        }
+
+        now = ktime_get_ns();
+    }
+
+    hrtimer_reprogram();
+    local_irq_restore(flags);
+}
+
+
+void hrtimer_tick(void)
+{
+    if(NULL == g_hrtimer_dev)
+        hrtimer_run_queues();
+}
+
+
+static void hrtimer_interrupt(struct clock_event_device *dev)
+{
+    (void) dev;
+    hrtimer_run_queues();
+}
+
+
+void hrtimer_register_device(struct clock_event_device *dev)
+{
+    unsigned long flags = local_irq_save();
+
+    dev->event_handler = hrtimer_interrupt;
+    g_hrtimer_dev = dev;
+    hrtimer_reprogram();
+
+    local_irq_restore(flags);
+
+    printk("hrtimer: %s\n", dev->name);
+}
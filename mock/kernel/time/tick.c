@@ -0,0 +1,266 @@
+#include <mock.h>
+#include <irq.h>
+#include <kernel/init.h>
+#include <kernel/jiffies.h>
+#include <kernel/clockevent.h>
+#include <kernel/clocksource.h>
+#include <kernel/timer.h>
+#include <kernel/hrtimer.h>
+#include <kernel/seqlock.h>
+#include <arch/irqflags.h>
+
+/*
+ * The tick.
+ *
+ * In periodic mode the tick device interrupts HZ times a second and every
+ * interrupt is one jiffy. In one-shot (CONFIG_NO_HZ) mode the device is
+ * programmed for the earliest deadline anyone asked for through
+ * tick_program_event(). Without such a deadline it is programmed as far out
+ * as it can go. On each interrupt, jiffies are caught up from the
+ * clocksource, so an idle machine takes a handful of interrupts a second
+ * instead of HZ.
+ */
+
+volatile uint32_t g_jiffies = 0;
+
+/* The full tick count and the time it was last advanced, published together */
+static seqcount_t g_tick_seq = SEQCNT_ZERO;
+static uint64_t g_jiffies_64 = 0;
+static uint64_t g_tick_last_ns = 0;
+
+static struct clock_event_device *g_tick_dev = NULL;
+static int g_tick_oneshot = 0;
+
+/* One-shot mode: when the next jiffy is due, and what the device is set for */
+static uint64_t g_tick_next_jiffy_ns = 0;
+static uint64_t g_tick_next_event_ns = 0;
+static uint64_t g_tick_requested_ns = ~0ull;
+
+/* Jiffy at which the next IRQ balancing pass is due */
+static uint32_t g_tick_next_balance = 0;
+
+
+/*
+ * Advance the tick count. Called from the tick interrupt, so readers on this
+ * CPU cannot run in the middle of it
+ */
+static void tick_do_update_jiffies(uint32_t ticks)
+{
+    uint64_t now = ktime_get_ns();
+
+    write_seqcount_begin(&g_tick_seq);
+    g_jiffies_64 += ticks;
+    g_jiffies = (uint32_t) g_jiffies_64;
+    g_tick_last_ns = now;
+    write_seqcount_end(&g_tick_seq);
+}
+
+
+uint64_t get_jiffies_64(void)
+{
+    uint64_t jiffies;
+    uint32_t seq;
+
+    do{
+        seq = read_seqcount_begin(&g_tick_seq);
+        jiffies = g_jiffies_64;
+    }while(read_seqcount_retry(&g_tick_seq, seq));
+
+    return jiffies;
+}
+
+
+uint64_t ktime_get_coarse_ns(void)
+{
+    uint64_t ns;
+    uint32_t seq;
+
+    do{
+        seq = read_seqcount_begin(&g_tick_seq);
+        ns = g_tick_last_ns;
+    }while(read_seqcount_retry(&g_tick_seq, seq));
+
+    return ns;
+}
+
+
+/*
+ * Work done once per jiffy, or once per batch of jiffies in one-shot mode
+ */
+static void tick_jiffies_work(void)
+{
+    timer_tick();
+
+    if(time_after_eq(g_jiffies, g_tick_next_balance)){
+        g_tick_next_balance = g_jiffies + IRQ_BALANCE_INTERVAL_SEC * HZ;
+        irq_balance_schedule();
+    }
+}
+
+
+static void tick_handle_periodic(struct clock_event_device *dev)
+{
+    (void) dev;
+
+    tick_do_update_jiffies(1);
+    tick_jiffies_work();
+    hrtimer_tick();
+}
+
+
+/*
+ * When jiffy 'j' begins, in ktime_get_ns() time; one-shot mode only
+ */
+static uint64_t tick_jiffy_to_ns(uint32_t j)
+{
+    int32_t ahead = (int32_t) (j - g_jiffies);
+
+    /* g_tick_next_jiffy_ns is the start of jiffy g_jiffies + 1 */
+    if(ahead <= 0)
+        return g_tick_next_jiffy_ns - TICK_NSEC;
+
+    return g_tick_next_jiffy_ns + (uint64_t) (ahead - 1) * TICK_NSEC;
+}
+
+
+static void tick_program(uint64_t now, uint64_t expires)
+{
+    uint64_t delta = (expires > now) ? expires - now : 0;
+
+    if(delta < g_tick_dev->min_delta_ns)
+        delta = g_tick_dev->min_delta_ns;
+    if(delta > g_tick_dev->max_delta_ns)
+        delta = g_tick_dev->max_delta_ns;
+
+    g_tick_next_event_ns = now + delta;
+    g_tick_dev->set_next_event(delta, g_tick_dev);
+}
+
+
+#ifdef CONFIG_NO_HZ
+static void tick_handle_oneshot(struct clock_event_device *dev)
+{
+    uint64_t now = ktime_get_ns();
+    uint64_t expires;
+    uint32_t next_timer;
+    uint32_t ticks = 0;
+    (void) dev;
+
+    while(now >= g_tick_next_jiffy_ns){
+        g_tick_next_jiffy_ns += TICK_NSEC;
+        ticks++;
+    }
+
+    if(0 != ticks){
+        tick_do_update_jiffies(ticks);
+        tick_jiffies_work();
+    }
+
+    /* Anything requested that has now passed has been served */
+    if(g_tick_requested_ns <= now)
+        g_tick_requested_ns = ~0ull;
+
+    /* Re-requests its next deadline, which is then in the future */
+    hrtimer_tick();
+
+    /* Keep the balancer's deadline in reach even with nothing else pending */
+    expires = tick_jiffy_to_ns(g_tick_next_balance);
+    if( (0 == timer_next_expiry(&next_timer)) && (tick_jiffy_to_ns(next_timer) < expires) )
+        expires = tick_jiffy_to_ns(next_timer);
+    if(g_tick_requested_ns < expires)
+        expires = g_tick_requested_ns;
+
+    tick_program(ktime_get_ns(), expires);
+}
+#endif /* CONFIG_NO_HZ */
+
+
+void tick_program_event(uint64_t expires_ns)
+{
+    unsigned long flags;
+
+    if(!g_tick_oneshot)
+        return;
+
+    flags = local_irq_save();
+
+    if(expires_ns < g_tick_requested_ns)
+        g_tick_requested_ns = expires_ns;
+
+    /* Only touch the hardware if this is earlier than what it is set for */
+    if(expires_ns < g_tick_next_event_ns)
+        tick_program(ktime_get_ns(), expires_ns);
+
+    local_irq_restore(flags);
+}
+
+
+void tick_program_jiffy(uint32_t j)
+{
+    unsigned long flags;
+
+    if(!g_tick_oneshot)
+        return;
+
+    /* The tick interrupt moves g_jiffies and the 64-bit next-jiffy time together */
+    flags = local_irq_save();
+    tick_program_event(tick_jiffy_to_ns(j));
+    local_irq_restore(flags);
+}
+
+
+void clockevents_register_device(struct clock_event_device *dev)
+{
+    if( (NULL != g_tick_dev) && (g_tick_dev->rating >= dev->rating) )
+        return;
+
+    g_tick_dev = dev;
+}
+
+
+void __init tick_init(void)
+{
+    if( (NULL == g_tick_dev) || !(g_tick_dev->features & CLOCK_EVT_FEAT_PERIODIC) ){
+        printk("tick: no periodic tick device!\n");
+        return;
+    }
+
+    g_tick_next_balance = IRQ_BALANCE_INTERVAL_SEC * HZ;
+    g_tick_dev->event_handler = tick_handle_periodic;
+    g_tick_dev->set_periodic(g_tick_dev);
+
+    printk("tick: %s, periodic at %u Hz\n", g_tick_dev->name, HZ);
+}
+
+
+int __init tick_nohz_enable(void)
+{
+#ifdef CONFIG_NO_HZ
+    const struct clocksource *cs = clocksource_current();
+    unsigned long flags;
+
+    if( (NULL == g_tick_dev) || !(g_tick_dev->features & CLOCK_EVT_FEAT_ONESHOT) )
+        return -1;
+
+    /* A tick-driven clocksource would stop counting along with the tick */
+    if( (NULL == cs) || (cs->rating <= CLOCKSOURCE_RATING_TICK) ){
+        printk("tick: no tick-independent clocksource, staying periodic\n");
+        return -1;
+    }
+
+    flags = local_irq_save();
+
+    g_tick_oneshot = 1;
+    g_tick_next_jiffy_ns = ktime_get_ns() + TICK_NSEC;
+    g_tick_next_event_ns = 0;
+    g_tick_dev->event_handler = tick_handle_oneshot;
+    tick_handle_oneshot(g_tick_dev);
+
+    local_irq_restore(flags);
+
+    printk("tick: %s, one-shot (tickless)\n", g_tick_dev->name);
+    return 0;
+#else
+    return -1;
+#endif
+}
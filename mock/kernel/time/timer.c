@@ -0,0 +1,268 @@
+#include <mock.h>
+#include <kernel/init.h>
+#include <kernel/timer.h>
+#include <kernel/jiffies.h>
+#include <kernel/softirq.h>
+#include <kernel/clockevent.h>
+#include <arch/irqflags.h>
+
+/*
+ * Hierarchical timer wheel.
+ *
+ * Timers sit in lists indexed by expiry time. tv1 has one list per jiffy for
+ * the next 256 jiffies. tv2 to tv5 each cover 64 times the range of the
+ * level below, with one list per slot of that coarser resolution. Arming or
+ * cancelling a timer is a list insert or delete, independent of how many
+ * timers there are.
+ *
+ * Every jiffy the current tv1 list expires as a batch. Each time tv1 wraps,
+ * the next slot of tv2 is cascaded: its timers are re-inserted, which
+ * spreads them over tv1. tv3 and up cascade the same way when the level
+ * below wraps. A timer is moved at most once per level over its lifetime.
+ *
+ * All wheel state is modified with interrupts disabled. Expired timers run
+ * from the timer softirq, with interrupts enabled.
+ */
+
+#define TVR_BITS        8
+#define TVN_BITS        6
+#define TVR_SIZE        (1 << TVR_BITS)
+#define TVN_SIZE        (1 << TVN_BITS)
+#define TVR_MASK        (TVR_SIZE - 1)
+#define TVN_MASK        (TVN_SIZE - 1)
+
+#define TV_SHIFT(n)     (TVR_BITS + ((n) - 1) * TVN_BITS)   /* For levels 1..4 (tv2..tv5) */
+#define NR_TVN          4
+
+struct timer_base {
+    uint32_t timer_jiffies;         /* Next jiffy to be processed */
+    uint32_t nr_pending;
+    struct list_head tv1[TVR_SIZE];
+    struct list_head tvn[NR_TVN][TVN_SIZE];
+};
+
+static struct timer_base g_timer_base;
+
+
+static inline unsigned int tvn_index(uint32_t j, int level)
+{
+    return (j >> TV_SHIFT(level + 1)) & TVN_MASK;
+}
+
+
+/*
+ * Put a timer in the list for its expiry. Called with interrupts disabled
+ */
+static void timer_enqueue(struct timer_base *base, struct timer_list *timer)
+{
+    uint32_t expires = timer->expires;
+    uint32_t delta = expires - base->timer_jiffies;
+    struct list_head *slot;
+
+    if( (int32_t) delta < 0 ){
+        /* Already due: expire on the next jiffy processed */
+        slot = &base->tv1[base->timer_jiffies & TVR_MASK];
+    }else if(delta < TVR_SIZE){
+        slot = &base->tv1[expires & TVR_MASK];
+    }else{
+        int level;
+
+        /* tv5 covers the rest; jiffies comparisons only reach 2^31 ahead anyway */
+        for(level = 0; level < NR_TVN - 1; level++){
+            if(delta < (1u << TV_SHIFT(level + 2)))
+                break;
+        }
+
+        slot = &base->tvn[level][tvn_index(expires, level)];
+    }
+
+    list_add_tail(&timer->entry, slot);
+}
+
+
+void timer_setup(struct timer_list *timer, void (*function)(struct timer_list *timer))
+{
+    list_init(&timer->entry);
+    timer->expires = 0;
+    timer->function = function;
+}
+
+
+int mod_timer(struct timer_list *timer, uint32_t expires)
+{
+    struct timer_base *base = &g_timer_base;
+    unsigned long flags = local_irq_save();
+    int was_pending = timer_pending(timer);
+
+    if(was_pending){
+        list_del(&timer->entry);
+    }else if(0 == base->nr_pending++){
+        /* The wheel was idle and may not have been advanced; nothing to catch up on */
+        base->timer_jiffies = g_jiffies;
+    }
+
+    timer->expires = expires;
+    timer_enqueue(base, timer);
+
+    local_irq_restore(flags);
+
+    /* A tickless tick must not sleep past this */
+    tick_program_jiffy(expires);
+
+    return was_pending;
+}
+
+
+int del_timer(struct timer_list *timer)
+{
+    unsigned long flags = local_irq_save();
+    int was_pending = timer_pending(timer);
+
+    if(was_pending){
+        list_del(&timer->entry);
+        g_timer_base.nr_pending--;
+    }
+
+    local_irq_restore(flags);
+    return was_pending;
+}
+
+
+/*
+ * Re-insert every timer of one slot of a coarse level. Returns the slot index,
+ * which tells the caller whether this level has wrapped as well
+ */
+static unsigned int cascade(struct timer_base *base, int level, unsigned int index)
+{
+    struct list_head list;
+
+    list_init(&list);
+    list_splice_tail_init(&base->tvn[level][index], &list);
+
+    while(!list_empty(&list)){
+        struct timer_list *timer = list_first_entry(&list, struct timer_list, entry);
+
+        list_del(&timer->entry);
+        timer_enqueue(base, timer);
+    }
+
+    return index;
+}
+
+
+static void run_timers(void)
+{
+    struct timer_base *base = &g_timer_base;
+    unsigned long flags = local_irq_save();
+
+    while(time_after_eq(g_jiffies, base->timer_jiffies)){
+        unsigned int index = base->timer_jiffies & TVR_MASK;
+        struct list_head work;
+
+        /* Nothing armed: skip straight to the present */
+        if(0 == base->nr_pending){
+            base->timer_jiffies = g_jiffies + 1;
+            break;
+        }
+
+        if(0 == index){
+            for(int level = 0; level < NR_TVN; level++){
+                if(0 != cascade(base, level, tvn_index(base->timer_jiffies, level)))
+                    break;
+            }
+        }
+
+        base->timer_jiffies++;
+
+        /* Detach the batch first, so handlers that re-arm land in a fresh list */
+        list_init(&work);
+        list_splice_tail_init(&base->tv1[index], &work);
+
+        while(!list_empty(&work)){
+            struct timer_list *timer = list_first_entry(&work, struct timer_list, entry);
+            void (*fn)(struct timer_list *) = timer->function;
+
+            list_del(&timer->entry);
+            base->nr_pending--;
+
+            local_irq_restore(flags);
+            fn(timer);
+            flags = local_irq_save();
+        }
+    }
+
+    local_irq_restore(flags);
+}
+
+
+void timer_tick(void)
+{
+    /* The expiry work itself is deferred to the softirq */
+    if(0 != g_timer_base.nr_pending)
+        raise_softirq(SOFTIRQ_TIMER);
+}
+
+
+/*
+ * The first non-empty tv1 slot is exact. A coarse slot only yields the jiffy
+ * it is cascaded at, which is no later than any of its timers; waking up then
+ * is early but safe. The earliest candidate over all levels wins
+ */
+int timer_next_expiry(uint32_t *next)
+{
+    struct timer_base *base = &g_timer_base;
+    unsigned long flags = local_irq_save();
+    int ret = -1;
+
+    if(0 == base->nr_pending)
+        goto out;
+
+    for(unsigned int i = 0; i < TVR_SIZE; i++){
+        uint32_t j = base->timer_jiffies + i;
+
+        if(!list_empty(&base->tv1[j & TVR_MASK])){
+            *next = j;
+            ret = 0;
+            break;
+        }
+    }
+
+    for(int level = 0; level < NR_TVN; level++){
+        uint32_t step = 1u << TV_SHIFT(level + 1);
+        /* The first slot cascaded from here on; right now if we sit on a boundary */
+        uint32_t j = (base->timer_jiffies + step - 1) & ~(step - 1);
+
+        for(unsigned int i = 0; i < TVN_SIZE; i++, j += step){
+            if(!list_empty(&base->tvn[level][tvn_index(j, level)])){
+                if( (0 != ret) || time_before(j, *next) ){
+                    *next = j;
+                    ret = 0;
+                }
+                break;
+            }
+        }
+    }
+
+out:
+    local_irq_restore(flags);
+    return ret;
+}
+
+
+void __init timer_init(void)
+{
+    struct timer_base *base = &g_timer_base;
+
+    base->timer_jiffies = g_jiffies;
+    base->nr_pending = 0;
+
+    for(int i = 0; i < TVR_SIZE; i++)
+        list_init(&base->tv1[i]);
+
+    for(int level = 0; level < NR_TVN; level++){
+        for(int i = 0; i < TVN_SIZE; i++)
+            list_init(&base->tvn[level][i]);
+    }
+
+    open_softirq(SOFTIRQ_TIMER, run_timers);
+}